@@ -0,0 +1,80 @@
+// CPU cost of binning N point lights into the 16x9x24 light grid of the clustered forward
+// path, on the calling thread alone and spread over a worker pool. The lights are scattered
+// at random around the islands and seen from where the camera usually looks at them. Also
+// reports how many lights a fragment ends up visiting: the average over the clusters that
+// have any against the N a shader without the grid would loop over.
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <rg/LightClusters.h>
+#include <rg/WorkerPool.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+const unsigned int WIDTH = 800;
+const unsigned int HEIGHT = 600;
+const unsigned int FRAMES = 500;
+const float Z_NEAR = 0.1f;
+const float Z_FAR = 100.0f;
+
+// island centers of the scene, the lights hang in a few units around them
+static const glm::vec3 ISLANDS[] = {
+        glm::vec3(68.0f, -11.0f, 20.0f),
+        glm::vec3(86.3f, -8.6f, 39.7f),
+        glm::vec3(67.5f, -6.9f, 39.9f),
+        glm::vec3(87.5f, -13.5f, 31.0f),
+        glm::vec3(63.7f, -13.4f, 35.0f),
+};
+
+static std::vector<rg::PointLightInstance> randomLights(unsigned int count) {
+    std::default_random_engine generator(count);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<rg::PointLightInstance> lights;
+    for (unsigned int i = 0; i < count; i++) {
+        const glm::vec3 &island = ISLANDS[i % (sizeof(ISLANDS) / sizeof(ISLANDS[0]))];
+        glm::vec3 offset = glm::vec3(unit(generator) - 0.5f, unit(generator) - 0.3f, unit(generator) - 0.5f) * 12.0f;
+        glm::vec3 color = glm::vec3(1.0f, 0.55f + unit(generator) * 0.25f, 0.2f + unit(generator) * 0.15f) * 3.0f;
+        lights.push_back(rg::PointLightInstance{island + offset, 1.0f + unit(generator) * 1.5f, color});
+    }
+    return lights;
+}
+
+static double buildMilliseconds(rg::LightGrid &grid, const std::vector<rg::PointLightInstance> &lights,
+                                const glm::mat4 &view, const glm::mat4 &projection, rg::WorkerPool &pool) {
+    grid.build(lights, view, projection, Z_NEAR, Z_FAR, pool);
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int frame = 0; frame < FRAMES; frame++)
+        grid.build(lights, view, projection, Z_NEAR, Z_FAR, pool);
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / FRAMES;
+}
+
+int main() {
+    glm::mat4 view = glm::lookAt(glm::vec3(75.0f, -4.0f, 60.0f), glm::vec3(75.0f, -10.0f, 30.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float) WIDTH / (float) HEIGHT, Z_NEAR, Z_FAR);
+
+    rg::WorkerPool serial(0);
+    rg::WorkerPool pool;
+    rg::LightGrid grid;
+
+    std::cout << "Light grid " << rg::LightGrid::TILES_X << "x" << rg::LightGrid::TILES_Y << "x" << rg::LightGrid::SLICES
+              << " build time, average of " << FRAMES << " builds, " << pool.size() << " threads in the pool\n";
+    unsigned int lightCounts[] = {64, 256, 1024, 4096};
+    for (unsigned int count : lightCounts) {
+        std::vector<rg::PointLightInstance> lights = randomLights(count);
+        double serialMs = buildMilliseconds(grid, lights, view, projection, serial);
+        double pooledMs = buildMilliseconds(grid, lights, view, projection, pool);
+
+        unsigned int occupied = 0;
+        for (const glm::uvec2 &range : grid.ranges())
+            occupied += range.y > 0 ? 1 : 0;
+        double perCluster = occupied > 0 ? (double) grid.indexCount() / occupied : 0.0;
+        std::cout << "  " << count << " lights: " << serialMs << " ms on one thread, " << pooledMs << " ms pooled ("
+                  << serialMs / pooledMs << "x); " << perCluster << " lights per lit cluster (max "
+                  << grid.maxClusterLights() << ", " << grid.overflow() << " dropped) instead of " << count << "\n";
+    }
+    std::cout << std::flush;
+    return 0;
+}
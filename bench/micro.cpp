@@ -0,0 +1,425 @@
+// Micro-benchmarks of the loader and the CPU side of a frame: stb_image decode of every
+// texture under resources/objects, Assimp import of every model, the aiMesh -> Vertex
+// conversion of processMesh, building instance matrices, frustum culling and the per-frame
+// uniform upload. Each benchmark is calibrated to a batch of iterations that runs for at
+// least BATCH_MILLISECONDS, then timed over --samples batches; the report is the median,
+// mean, standard deviation and range of the time per iteration.
+//
+// usage: bench [--list] [--samples N] [--json FILE] [--baseline FILE] [NAME_OR_PREFIX...]
+// Names or prefixes (e.g. "frustum_cull/" or "assimp_import/airman") pick what runs, all of
+// it by default. --json writes the results, --baseline compares against an earlier --json.
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/filesystem.h>
+#include <learnopengl/shader.h>
+#include <learnopengl/model.h>
+#include <rg/Frustum.h>
+#include <rg/Headless.h>
+#include <rg/UniformBlocks.h>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+const double BATCH_MILLISECONDS = 20.0;
+const unsigned int MAX_BATCH = 1u << 20;
+
+// keeps the compiler from dropping work whose result is never used
+template<typename T>
+static void keep(const T &value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+struct Benchmark {
+    std::string name;
+    bool gl;    // needs a current GL context
+    // does the setup and returns one iteration of the measured work
+    std::function<std::function<void()>()> prepare;
+};
+
+struct Result {
+    std::string name;
+    unsigned int iterations;    // per sample
+    unsigned int samples;
+    double median, mean, stddev, minimum, maximum;  // nanoseconds per iteration
+};
+
+static std::vector<Benchmark> &registry() {
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+static void add(const std::string &name, bool gl, std::function<std::function<void()>()> prepare) {
+    registry().push_back(Benchmark{name, gl, std::move(prepare)});
+}
+
+static double batchNanoseconds(const std::function<void()> &iteration, unsigned int iterations) {
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < iterations; i++)
+        iteration();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+static Result run(const Benchmark &benchmark, unsigned int samples) {
+    std::function<void()> iteration = benchmark.prepare();
+    // warms caches and finds a batch long enough for the clock
+    unsigned int iterations = 1;
+    while (iterations < MAX_BATCH && batchNanoseconds(iteration, iterations) < BATCH_MILLISECONDS * 1.0e6)
+        iterations *= 2;
+
+    std::vector<double> perIteration;
+    for (unsigned int s = 0; s < samples; s++)
+        perIteration.push_back(batchNanoseconds(iteration, iterations) / iterations);
+    std::sort(perIteration.begin(), perIteration.end());
+
+    Result result = Result{benchmark.name, iterations, samples, 0.0, 0.0, 0.0, perIteration.front(), perIteration.back()};
+    size_t middle = perIteration.size() / 2;
+    result.median = perIteration.size() % 2 ? perIteration[middle] : (perIteration[middle - 1] + perIteration[middle]) * 0.5;
+    for (double value : perIteration)
+        result.mean += value;
+    result.mean /= perIteration.size();
+    for (double value : perIteration)
+        result.stddev += (value - result.mean) * (value - result.mean);
+    result.stddev = perIteration.size() > 1 ? std::sqrt(result.stddev / (perIteration.size() - 1)) : 0.0;
+    return result;
+}
+
+// --- inputs --------------------------------------------------------------------------------
+
+static bool hasExtension(const std::string &name, std::initializer_list<const char *> extensions) {
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    for (const char *extension : extensions) {
+        std::string suffix = extension;
+        if (lower.size() > suffix.size() && lower.compare(lower.size() - suffix.size(), suffix.size(), suffix) == 0)
+            return true;
+    }
+    return false;
+}
+
+// files under root (recursively) with one of the extensions, relative to root, sorted
+static void listFiles(const std::string &root, const std::string &relative, std::initializer_list<const char *> extensions,
+                      std::vector<std::string> &files) {
+    DIR *directory = opendir((root + "/" + relative).c_str());
+    if (directory == NULL)
+        return;
+    while (dirent *entry = readdir(directory)) {
+        std::string name = entry->d_name;
+        if (name == "." || name == "..")
+            continue;
+        std::string path = relative.empty() ? name : relative + "/" + name;
+        struct stat info;
+        if (stat((root + "/" + path).c_str(), &info) != 0)
+            continue;
+        if (S_ISDIR(info.st_mode))
+            listFiles(root, path, extensions, files);
+        else if (hasExtension(name, extensions))
+            files.push_back(path);
+    }
+    closedir(directory);
+    std::sort(files.begin(), files.end());
+}
+
+static std::vector<unsigned char> readFile(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<unsigned char>((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+const unsigned int IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace;
+
+// the scene of the island: model matrices the way the render loop builds them
+static std::vector<glm::mat4> instanceMatrices(unsigned int count, float time) {
+    std::vector<glm::mat4> matrices(count);
+    for (unsigned int i = 0; i < count; i++) {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(60.0f + (i % 32), -11.0f + std::cos(time + i) * 0.4f, 20.0f + (i / 32) % 32));
+        model = glm::scale(model, glm::vec3(0.1f));
+        model = glm::rotate(model, glm::radians(45.0f + i), glm::vec3(0.0f, 1.0f, 0.0f));
+        matrices[i] = model;
+    }
+    return matrices;
+}
+
+static void registerBenchmarks() {
+    const std::string objects = FileSystem::getPath("resources/objects");
+
+    // decode from memory so only stb_image is measured, not the disk
+    std::vector<std::string> textures;
+    listFiles(objects, "", {".png", ".jpg", ".jpeg"}, textures);
+    for (const std::string &texture : textures) {
+        add("stb_decode/" + texture, false, [objects, texture]() {
+            std::shared_ptr<std::vector<unsigned char>> file = std::make_shared<std::vector<unsigned char>>(readFile(objects + "/" + texture));
+            return std::function<void()>([file]() {
+                int width, height, components;
+                stbi_uc *pixels = stbi_load_from_memory(&(*file)[0], (int) file->size(), &width, &height, &components, 0);
+                keep(pixels);
+                stbi_image_free(pixels);
+            });
+        });
+    }
+
+    std::vector<std::string> models;
+    listFiles(objects, "", {".gltf", ".glb", ".obj", ".fbx"}, models);
+    for (const std::string &model : models) {
+        std::string path = objects + "/" + model;
+        add("assimp_import/" + model, false, [path]() {
+            return std::function<void()>([path]() {
+                Assimp::Importer importer;
+                const aiScene *scene = importer.ReadFile(path, IMPORT_FLAGS);
+                keep(scene);
+            });
+        });
+        add("process_mesh/" + model, false, [path]() {
+            std::shared_ptr<Assimp::Importer> importer = std::make_shared<Assimp::Importer>();
+            const aiScene *scene = importer->ReadFile(path, IMPORT_FLAGS);
+            return std::function<void()>([importer, scene]() {
+                for (unsigned int m = 0; scene != NULL && m < scene->mNumMeshes; m++) {
+                    vector<Vertex> vertices;
+                    vector<unsigned int> indices;
+                    Model::ConvertMesh(scene->mMeshes[m], vertices, indices);
+                    keep(vertices);
+                }
+            });
+        });
+    }
+
+    for (unsigned int count : {1000u, 10000u, 100000u}) {
+        add("instance_matrices/" + std::to_string(count), false, [count]() {
+            std::shared_ptr<float> time = std::make_shared<float>(0.0f);
+            return std::function<void()>([count, time]() {
+                std::vector<glm::mat4> matrices = instanceMatrices(count, *time += 0.016f);
+                keep(matrices[0]);
+            });
+        });
+
+        // local boxes moved by each instance's matrix and tested against the camera's frustum
+        add("frustum_cull/" + std::to_string(count), false, [count]() {
+            struct Scene {
+                std::vector<glm::mat4> matrices;
+                rg::Bounds local;
+                rg::Frustum frustum;
+                std::vector<unsigned int> visible;
+            };
+            std::shared_ptr<Scene> scene = std::make_shared<Scene>();
+            scene->matrices = instanceMatrices(count, 0.0f);
+            scene->local.add(glm::vec3(-10.0f, -2.0f, -10.0f));
+            scene->local.add(glm::vec3(10.0f, 8.0f, 10.0f));
+            glm::mat4 view = glm::lookAt(glm::vec3(63.5f, -4.1f, 42.7f), glm::vec3(64.0f, -4.6f, 42.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+            glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+            scene->frustum = rg::Frustum(projection * view);
+            scene->visible.reserve(count);
+            return std::function<void()>([scene]() {
+                scene->visible.clear();
+                for (unsigned int i = 0; i < scene->matrices.size(); i++) {
+                    if (scene->frustum.intersects(scene->local.transformed(scene->matrices[i])))
+                        scene->visible.push_back(i);
+                }
+                keep(scene->visible.size());
+            });
+        });
+    }
+
+    // what the render loop uploads per frame: the FrameData block and a model matrix per object
+    for (unsigned int objects : {16u, 256u}) {
+        add("uniform_upload/" + std::to_string(objects), true, [objects]() {
+            struct Upload {
+                std::unique_ptr<Shader> shader;
+                int model;
+                std::unique_ptr<rg::UniformBuffer<rg::FrameData>> frame;
+                rg::FrameData frameData = rg::FrameData();
+                std::vector<glm::mat4> matrices;
+                float time = 0.0f;
+            };
+            std::shared_ptr<Upload> upload = std::make_shared<Upload>();
+            upload->shader.reset(new Shader(FileSystem::getPath("resources/shaders/2.model_lighting.vs").c_str(),
+                                            FileSystem::getPath("resources/shaders/2.model_lighting.fs").c_str()));
+            upload->shader->use();
+            upload->model = upload->shader->uniform("model");
+            upload->frame.reset(new rg::UniformBuffer<rg::FrameData>(rg::FRAME_DATA_BINDING));
+            upload->matrices = instanceMatrices(objects, 0.0f);
+            upload->frameData.projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+            return std::function<void()>([upload]() {
+                upload->time += 0.016f;
+                upload->frameData.view = glm::lookAt(glm::vec3(70.0f, -5.0f + std::sin(upload->time), 60.0f),
+                                                     glm::vec3(70.0f, -10.0f, 30.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+                upload->frameData.time = upload->time;
+                upload->frame->update(upload->frameData);
+                for (glm::mat4 &matrix : upload->matrices) {
+                    matrix[3][1] = std::cos(upload->time) * 0.4f;
+                    upload->shader->setMat4(upload->model, matrix);
+                }
+                // the driver queues the uploads, finishing each iteration keeps the cost in it
+                glFinish();
+            });
+        });
+    }
+}
+
+// --- context and output --------------------------------------------------------------------
+
+// headless when EGL is there, a hidden GLFW window otherwise
+static bool createContext(rg::HeadlessContext &headless, GLFWwindow *&window) {
+    std::string error;
+    if (headless.create(error))
+        return gladLoadGLLoader((GLADloadproc) rg::HeadlessContext::getProcAddress) != 0;
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+    window = glfwCreateWindow(64, 64, "bench", NULL, NULL);
+    if (window == NULL)
+        return false;
+    glfwMakeContextCurrent(window);
+    return gladLoadGLLoader((GLADloadproc) glfwGetProcAddress) != 0;
+}
+
+static std::string escape(const std::string &text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\')
+            escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+// one benchmark per line, so --baseline can read it back without a JSON parser
+static bool writeJson(const std::string &path, const std::vector<Result> &results) {
+    std::ofstream out(path);
+    if (!out)
+        return false;
+    out << std::setprecision(6) << "{\"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result &r = results[i];
+        out << "  {\"name\": \"" << escape(r.name) << "\", \"iterations\": " << r.iterations << ", \"samples\": " << r.samples
+            << ", \"median_ns\": " << r.median << ", \"mean_ns\": " << r.mean << ", \"stddev_ns\": " << r.stddev
+            << ", \"min_ns\": " << r.minimum << ", \"max_ns\": " << r.maximum << "}" << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "]}\n";
+    return (bool) out;
+}
+
+// median per name from a file written by writeJson
+static std::map<std::string, double> readBaseline(const std::string &path) {
+    std::map<std::string, double> medians;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t name = line.find("\"name\": \"");
+        size_t median = line.find("\"median_ns\": ");
+        if (name == std::string::npos || median == std::string::npos)
+            continue;
+        name += 9;
+        medians[line.substr(name, line.find('"', name) - name)] = std::atof(line.c_str() + median + 13);
+    }
+    return medians;
+}
+
+static std::string formatTime(double nanoseconds) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2);
+    if (nanoseconds >= 1.0e6)
+        out << nanoseconds / 1.0e6 << " ms";
+    else if (nanoseconds >= 1.0e3)
+        out << nanoseconds / 1.0e3 << " us";
+    else
+        out << nanoseconds << " ns";
+    return out.str();
+}
+
+int main(int argc, char **argv) {
+    unsigned int samples = 10;
+    std::string jsonPath, baselinePath;
+    std::vector<std::string> selected;
+    bool list = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--list")
+            list = true;
+        else if (arg == "--samples" && i + 1 < argc)
+            samples = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--json" && i + 1 < argc)
+            jsonPath = argv[++i];
+        else if (arg == "--baseline" && i + 1 < argc)
+            baselinePath = argv[++i];
+        else if (arg.compare(0, 2, "--") == 0) {
+            std::cout << "usage: bench [--list] [--samples N] [--json FILE] [--baseline FILE] [NAME_OR_PREFIX...]\n";
+            return arg == "--help" ? 0 : -1;
+        } else
+            selected.push_back(arg);
+    }
+
+    registerBenchmarks();
+    std::vector<const Benchmark *> chosen;
+    bool needsGL = false;
+    for (const Benchmark &benchmark : registry()) {
+        bool match = selected.empty();
+        for (const std::string &prefix : selected)
+            match = match || benchmark.name.compare(0, prefix.size(), prefix) == 0;
+        if (!match)
+            continue;
+        chosen.push_back(&benchmark);
+        needsGL = needsGL || benchmark.gl;
+    }
+    if (list) {
+        for (const Benchmark *benchmark : chosen)
+            std::cout << benchmark->name << (benchmark->gl ? "  (GL)" : "") << "\n";
+        return 0;
+    }
+    if (chosen.empty()) {
+        std::cout << "no benchmark matches, see --list" << std::endl;
+        return -1;
+    }
+
+    rg::HeadlessContext headless;
+    GLFWwindow *window = NULL;
+    if (needsGL && !createContext(headless, window)) {
+        std::cout << "Failed to create an OpenGL context" << std::endl;
+        return -1;
+    }
+
+    std::map<std::string, double> baseline;
+    if (!baselinePath.empty())
+        baseline = readBaseline(baselinePath);
+    std::vector<Result> results;
+    for (const Benchmark *benchmark : chosen) {
+        Result result = run(*benchmark, samples);
+        results.push_back(result);
+        std::cout << std::left << std::setw(60) << result.name << " median " << std::setw(11) << formatTime(result.median)
+                  << " mean " << std::setw(11) << formatTime(result.mean) << " +- " << std::setw(11) << formatTime(result.stddev)
+                  << " (" << result.iterations << " x " << result.samples << ")";
+        std::map<std::string, double>::const_iterator before = baseline.find(result.name);
+        if (before != baseline.end() && before->second > 0.0)
+            std::cout << "  " << std::showpos << std::fixed << std::setprecision(1)
+                      << (result.median / before->second - 1.0) * 100.0 << "%" << std::noshowpos << std::defaultfloat;
+        std::cout << std::endl;
+    }
+
+    if (!jsonPath.empty() && !writeJson(jsonPath, results)) {
+        std::cout << "Failed to write " << jsonPath << std::endl;
+        return -1;
+    }
+    if (window != NULL)
+        glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,22 @@
+#version 330 core
+// reference copy of the model shader from before the FrameData/LightData uniform blocks, camera
+// and lights still loose uniforms; kept for bench_uniforms
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+
+out vec2 TexCoords;
+out vec3 Normal;
+out vec3 FragPos;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    FragPos = vec3(model * vec4(aPos, 1.0));
+    Normal = aNormal;
+    TexCoords = aTexCoords;    
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
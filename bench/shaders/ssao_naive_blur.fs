@@ -1,4 +1,5 @@
 #version 330 core
+// reference copy of the old 4x4 box blur, kept for bench_ssao
 out float FragColor;
 
 in vec2 TexCoords;
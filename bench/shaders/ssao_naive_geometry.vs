@@ -10,8 +10,14 @@ out vec3 Normal;
 uniform bool invertedNormals;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 cameraPosition;
+    float time;
+    float deltaTime;
+};
 
 void main()
 {
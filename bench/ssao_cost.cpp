@@ -0,0 +1,277 @@
+// GPU time of the ambient occlusion pass at the renderer's 800x600, measured with timer
+// queries: the full resolution version the renderer used to ship (64 samples read from a
+// position buffer, kernel uploaded as 64 string-named uniforms every frame, 4x4 box blur)
+// against rg::SSAO (half resolution, depth reconstruction, kernel in a uniform block,
+// depth-aware blur + upsample) at a few sample counts. The scene is a field of cubes of
+// different heights drawn into a g-buffer, so both versions read the same depth.
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/filesystem.h>
+#include <learnopengl/shader.h>
+#include <rg/RenderTargetPool.h>
+#include <rg/SSAO.h>
+#include <rg/UniformBlocks.h>
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+const unsigned int WIDTH = 800;
+const unsigned int HEIGHT = 600;
+const unsigned int FRAMES = 200;
+const int GRID = 12;
+
+static unsigned int quadVAO = 0;
+
+static void drawQuad() {
+    if (quadVAO == 0) {
+        float vertices[] = {
+                -1.0f,  1.0f, 0.0f, 0.0f, 1.0f,
+                -1.0f, -1.0f, 0.0f, 0.0f, 0.0f,
+                 1.0f,  1.0f, 0.0f, 1.0f, 1.0f,
+                 1.0f, -1.0f, 0.0f, 1.0f, 0.0f,
+        };
+        unsigned int vbo;
+        glGenVertexArrays(1, &quadVAO);
+        glGenBuffers(1, &vbo);
+        glBindVertexArray(quadVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+    }
+    rg::glState().bindVertexArray(quadVAO);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
+
+// unit cube with position, normal and texcoords, the layout ssao_naive_geometry.vs expects
+static unsigned int createCube() {
+    std::vector<float> vertices;
+    for (int axis = 0; axis < 3; axis++) {
+        for (int sign = -1; sign <= 1; sign += 2) {
+            glm::vec3 normal(0.0f);
+            normal[axis] = (float)sign;
+            glm::vec3 u(0.0f), v(0.0f);
+            u[(axis + 1) % 3] = 1.0f;
+            v[(axis + 2) % 3] = 1.0f;
+            if (sign < 0)
+                std::swap(u, v);
+            glm::vec3 corners[4] = {normal - u - v, normal + u - v, normal + u + v, normal - u + v};
+            int order[6] = {0, 1, 2, 2, 3, 0};
+            for (int i : order) {
+                const glm::vec3& p = corners[i];
+                float vertex[8] = {p.x, p.y, p.z, normal.x, normal.y, normal.z, 0.0f, 0.0f};
+                vertices.insert(vertices.end(), vertex, vertex + 8);
+            }
+        }
+    }
+    unsigned int vao, vbo;
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), &vertices[0], GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    return vao;
+}
+
+static unsigned int createTexture(GLenum internalFormat, GLenum format, GLenum type) {
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, WIDTH, HEIGHT, 0, format, type, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return texture;
+}
+
+static unsigned int createTarget(unsigned int texture) {
+    unsigned int fbo;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    return fbo;
+}
+
+// average GPU milliseconds of one call of pass over FRAMES frames
+template <typename F>
+static double gpuMilliseconds(F pass) {
+    std::vector<GLuint> queries(FRAMES);
+    glGenQueries(FRAMES, &queries[0]);
+    for (unsigned int i = 0; i < FRAMES; ++i) {
+        glBeginQuery(GL_TIME_ELAPSED, queries[i]);
+        pass();
+        glEndQuery(GL_TIME_ELAPSED);
+    }
+    double total = 0.0;
+    for (unsigned int i = 0; i < FRAMES; ++i) {
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &elapsed);
+        total += (double)elapsed;
+    }
+    glDeleteQueries(FRAMES, &queries[0]);
+    return total / FRAMES / 1.0e6;
+}
+
+int main() {
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+    GLFWwindow *window = glfwCreateWindow(64, 64, "bench_ssao", NULL, NULL);
+    if (window == NULL) {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    rg::GLState& state = rg::glState();
+
+    // g-buffer as the old path needed it: view-space position, normal, albedo and depth
+    unsigned int gPosition = createTexture(GL_RGBA16F, GL_RGBA, GL_FLOAT);
+    unsigned int gNormal = createTexture(GL_RGBA16F, GL_RGBA, GL_FLOAT);
+    unsigned int gAlbedo = createTexture(GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE);
+    unsigned int depth = createTexture(GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT);
+    unsigned int gBuffer;
+    glGenFramebuffers(1, &gBuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gPosition, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, gNormal, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, gAlbedo, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth, 0);
+    unsigned int attachments[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+    glDrawBuffers(3, attachments);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "Framebuffer not complete!" << std::endl;
+
+    unsigned int naiveAO = createTexture(GL_RED, GL_RED, GL_FLOAT);
+    unsigned int naiveBlurred = createTexture(GL_RED, GL_RED, GL_FLOAT);
+    unsigned int naiveFBO = createTarget(naiveAO);
+    unsigned int naiveBlurFBO = createTarget(naiveBlurred);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    rg::UniformBuffer<rg::FrameData> frameBuffer(rg::FRAME_DATA_BINDING);
+    rg::FrameData frameData = rg::FrameData();
+    frameData.view = glm::lookAt(glm::vec3(0.0f, 9.0f, 16.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    frameData.projection = glm::perspective(glm::radians(45.0f), (float)WIDTH / (float)HEIGHT, 0.1f, 100.0f);
+    frameBuffer.update(frameData);
+
+    Shader geometry(FileSystem::getPath("bench/shaders/ssao_naive_geometry.vs").c_str(),
+                    FileSystem::getPath("bench/shaders/ssao_naive_geometry.fs").c_str());
+    Shader naive(FileSystem::getPath("resources/shaders/ssao.vs").c_str(),
+                 FileSystem::getPath("bench/shaders/ssao_naive.fs").c_str());
+    Shader naiveBlur(FileSystem::getPath("resources/shaders/ssao.vs").c_str(),
+                     FileSystem::getPath("bench/shaders/ssao_naive_blur.fs").c_str());
+    rg::RenderTargetPool renderTargets;
+    rg::SSAO ssao(renderTargets);
+
+    // cubes of random height on a floor
+    unsigned int cube = createCube();
+    std::default_random_engine generator;
+    std::uniform_real_distribution<float> heights(0.2f, 2.0f);
+    state.bindFramebuffer(gBuffer);
+    glViewport(0, 0, WIDTH, HEIGHT);
+    state.enable(GL_DEPTH_TEST);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    geometry.use();
+    geometry.setInt("invertedNormals", 0);
+    state.bindVertexArray(cube);
+    glm::mat4 floor = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1.0f, 0.0f)), glm::vec3(20.0f, 1.0f, 20.0f));
+    geometry.setMat4("model", floor);
+    glDrawArrays(GL_TRIANGLES, 0, 36);
+    for (int x = -GRID / 2; x < GRID / 2; x++) {
+        for (int z = -GRID / 2; z < GRID / 2; z++) {
+            float height = heights(generator);
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(x * 1.5f, height * 0.5f, z * 1.5f));
+            model = glm::scale(model, glm::vec3(0.5f, height * 0.5f, 0.5f));
+            geometry.setMat4("model", model);
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+        }
+    }
+    state.disable(GL_DEPTH_TEST);
+
+    // the old kernel and noise, generated the same way the renderer did
+    std::uniform_real_distribution<GLfloat> randomFloats(0.0, 1.0);
+    std::vector<glm::vec3> kernel;
+    for (unsigned int i = 0; i < 64; ++i) {
+        glm::vec3 sample(randomFloats(generator) * 2.0 - 1.0, randomFloats(generator) * 2.0 - 1.0, randomFloats(generator));
+        sample = glm::normalize(sample) * randomFloats(generator);
+        float scale = float(i) / 64.0f;
+        sample *= 0.1f + scale * scale * 0.9f;
+        kernel.push_back(sample);
+    }
+    std::vector<glm::vec3> noise;
+    for (unsigned int i = 0; i < 16; i++)
+        noise.push_back(glm::vec3(randomFloats(generator) * 2.0 - 1.0, randomFloats(generator) * 2.0 - 1.0, 0.0f));
+    unsigned int noiseTexture;
+    glGenTextures(1, &noiseTexture);
+    glBindTexture(GL_TEXTURE_2D, noiseTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, 4, 4, 0, GL_RGB, GL_FLOAT, &noise[0]);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    state.invalidate();
+
+    naive.use();
+    naive.setInt("gPosition", 0);
+    naive.setInt("gNormal", 1);
+    naive.setInt("texNoise", 2);
+    naiveBlur.use();
+    naiveBlur.setInt("ssaoInput", 0);
+
+    double naiveMs = gpuMilliseconds([&]() {
+        state.bindFramebuffer(naiveFBO);
+        naive.use();
+        // the old loop: 64 lookups by name every frame
+        for (unsigned int i = 0; i < 64; ++i)
+            glUniform3fv(glGetUniformLocation(naive.ID, ("samples[" + std::to_string(i) + "]").c_str()), 1, &kernel[i][0]);
+        state.bindTexture(0, GL_TEXTURE_2D, gPosition);
+        state.bindTexture(1, GL_TEXTURE_2D, gNormal);
+        state.bindTexture(2, GL_TEXTURE_2D, noiseTexture);
+        drawQuad();
+        state.bindFramebuffer(naiveBlurFBO);
+        naiveBlur.use();
+        state.bindTexture(0, GL_TEXTURE_2D, naiveAO);
+        drawQuad();
+    });
+
+    std::cout << "SSAO GPU time at " << WIDTH << "x" << HEIGHT << ", average of " << FRAMES << " frames\n"
+              << "  full resolution, 64 samples + box blur:  " << naiveMs << " ms\n";
+    unsigned int sampleCounts[] = {8, 16, 32, 64};
+    for (unsigned int samples : sampleCounts) {
+        ssao.sampleCount = samples;
+        double ms = gpuMilliseconds([&]() {
+            GLuint occlusion = renderTargets.acquire(rg::SSAO::targetDesc(WIDTH, HEIGHT));
+            ssao.render(depth, occlusion, WIDTH, HEIGHT, frameData.projection, drawQuad);
+            renderTargets.endFrame();
+        });
+        std::cout << "  half resolution, " << samples << " samples + bilateral upsample: "
+                  << ms << " ms (" << naiveMs / ms << "x)\n";
+    }
+    std::cout << std::flush;
+
+    glfwTerminate();
+    return 0;
+}
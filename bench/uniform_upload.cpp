@@ -0,0 +1,183 @@
+// Measures the CPU cost of one frame's worth of uniform uploads to the model shader,
+// once the way the render loop used to do it (glGetUniformLocation with freshly built
+// strings for every set, against bench/shaders/model_lighting_loose.*, the model shader from
+// before the uniform blocks, which still declares camera and lights as loose uniforms) and
+// once through reflected handles with value shadowing, with camera and light data going
+// through the shared FrameData/LightData uniform blocks. GL calls per frame are counted by
+// GLStats for both paths, after the timed runs so the counting wrappers don't skew them.
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/filesystem.h>
+#include <learnopengl/shader.h>
+#include <rg/GLStats.h>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// draws of the island scene per frame and textures bound per mesh
+const unsigned int OBJECTS = 16;
+const unsigned int MESHES_PER_OBJECT = 12;
+const unsigned int FRAMES = 2000;
+
+static void uploadBefore(unsigned int program, float time) {
+    glm::mat4 view = glm::lookAt(glm::vec3(70.0f, -5.0f, 60.0f), glm::vec3(70.0f, -10.0f, 30.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+    glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, &projection[0][0]);
+    glUniformMatrix4fv(glGetUniformLocation(program, std::string("view").c_str()), 1, GL_FALSE, &view[0][0]);
+    const char* pointLightVec3[] = {"pointLight.position", "pointLight.ambient", "pointLight.diffuse", "pointLight.specular"};
+    for (const char* name : pointLightVec3)
+        glUniform3f(glGetUniformLocation(program, std::string(name).c_str()), 0.4f, 0.4f, 0.4f);
+    const char* pointLightFloat[] = {"pointLight.constant", "pointLight.linear", "pointLight.quadratic"};
+    for (const char* name : pointLightFloat)
+        glUniform1f(glGetUniformLocation(program, std::string(name).c_str()), 1.0f);
+    glUniform3f(glGetUniformLocation(program, std::string("viewPosition").c_str()), 70.0f, -5.0f, 60.0f);
+    glUniform1f(glGetUniformLocation(program, std::string("material.shininessBP").c_str()), 32.0f);
+    glUniform1f(glGetUniformLocation(program, std::string("material.shininess").c_str()), 8.0f);
+    glUniform1i(glGetUniformLocation(program, std::string("blinn").c_str()), 1);
+    const char* dirLightVec3[] = {"dirLight.direction", "dirLight.ambient", "dirLight.diffuse", "dirLight.specular"};
+    for (const char* name : dirLightVec3)
+        glUniform3f(glGetUniformLocation(program, std::string(name).c_str()), 0.05f, 0.05f, 0.05f);
+
+    std::string prefix = "material.";
+    for (unsigned int object = 0; object < OBJECTS; ++object) {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(object, std::cos(time) * 0.4f, 0.0f));
+        glUniformMatrix4fv(glGetUniformLocation(program, std::string("model").c_str()), 1, GL_FALSE, &model[0][0]);
+        for (unsigned int mesh = 0; mesh < MESHES_PER_OBJECT; ++mesh) {
+            std::string diffuse = "texture_diffuse";
+            std::string specular = "texture_specular";
+            glUniform1i(glGetUniformLocation(program, (prefix + diffuse + std::to_string(1)).c_str()), 0);
+            glUniform1i(glGetUniformLocation(program, (prefix + specular + std::to_string(1)).c_str()), 1);
+        }
+    }
+}
+
+struct Handles {
+    int shininessBP, shininess, blinn, model, diffuse, specular;
+};
+
+struct Blocks {
+    rg::UniformBuffer<rg::FrameData> frame{rg::FRAME_DATA_BINDING};
+    rg::UniformBuffer<rg::LightData> lights{rg::LIGHT_DATA_BINDING};
+    rg::FrameData frameData = rg::FrameData();
+    rg::LightData lightData = rg::LightData();
+};
+
+static void uploadAfter(Shader& shader, const Handles& h, Blocks& blocks, float time) {
+    blocks.frameData.view = glm::lookAt(glm::vec3(70.0f, -5.0f, 60.0f), glm::vec3(70.0f, -10.0f, 30.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    blocks.frameData.projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+    blocks.frameData.cameraPosition = glm::vec3(70.0f, -5.0f, 60.0f);
+    blocks.frameData.time = time;
+    blocks.frame.update(blocks.frameData);
+    blocks.lightData.pointLight.position = glm::vec3(0.4f);
+    blocks.lightData.pointLight.ambient = glm::vec3(0.4f);
+    blocks.lightData.pointLight.diffuse = glm::vec3(0.4f);
+    blocks.lightData.pointLight.specular = glm::vec3(0.4f);
+    blocks.lightData.pointLight.constant = 1.0f;
+    blocks.lightData.pointLight.linear = 1.0f;
+    blocks.lightData.pointLight.quadratic = 1.0f;
+    blocks.lightData.dirLight.direction = glm::vec3(0.05f);
+    blocks.lightData.dirLight.ambient = glm::vec3(0.05f);
+    blocks.lightData.dirLight.diffuse = glm::vec3(0.05f);
+    blocks.lightData.dirLight.specular = glm::vec3(0.05f);
+    blocks.lights.update(blocks.lightData);
+    shader.setFloat(h.shininessBP, 32.0f);
+    shader.setFloat(h.shininess, 8.0f);
+    shader.setInt(h.blinn, 1);
+
+    for (unsigned int object = 0; object < OBJECTS; ++object) {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(object, std::cos(time) * 0.4f, 0.0f));
+        shader.setMat4(h.model, model);
+        for (unsigned int mesh = 0; mesh < MESHES_PER_OBJECT; ++mesh) {
+            shader.setInt(h.diffuse, 0);
+            shader.setInt(h.specular, 1);
+        }
+    }
+}
+
+template <typename F>
+static double nanosecondsPerFrame(F frame) {
+    glFinish();
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < FRAMES; ++i)
+        frame((float)i * 0.016f);
+    glFinish();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / FRAMES;
+}
+
+// GL calls of one warm frame, the second of two so shadowed values are already in place
+template <typename F>
+static unsigned long callsPerFrame(F frame) {
+    frame(0.0f);
+    rg::glStats().endFrame();
+    frame(0.016f);
+    rg::glStats().endFrame();
+    return rg::glStats().lastFrame().calls;
+}
+
+int main() {
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+    GLFWwindow *window = glfwCreateWindow(64, 64, "bench_uniforms", NULL, NULL);
+    if (window == NULL) {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    Shader loose(FileSystem::getPath("bench/shaders/model_lighting_loose.vs").c_str(),
+                 FileSystem::getPath("bench/shaders/model_lighting_loose.fs").c_str());
+    Shader shader(FileSystem::getPath("resources/shaders/2.model_lighting.vs").c_str(),
+                  FileSystem::getPath("resources/shaders/2.model_lighting.fs").c_str());
+
+    Handles h;
+    h.shininessBP = shader.uniform("material.shininessBP");
+    h.shininess = shader.uniform("material.shininess");
+    h.blinn = shader.uniform("blinn");
+    h.model = shader.uniform("model");
+    h.diffuse = shader.uniform("material.texture_diffuse1");
+    h.specular = shader.uniform("material.texture_specular1");
+    Blocks blocks;
+
+    unsigned int program = loose.ID;
+    auto before = [program](float time) { uploadBefore(program, time); };
+    auto after = [&shader, &h, &blocks](float time) { uploadAfter(shader, h, blocks, time); };
+    loose.use();
+    double beforeNanoseconds = nanosecondsPerFrame(before);
+    shader.use();
+    double afterNanoseconds = nanosecondsPerFrame(after);
+
+    rg::glStats().install();
+    loose.use();
+    unsigned long callsBefore = callsPerFrame(before);
+    shader.use();
+    unsigned long callsAfter = callsPerFrame(after);
+
+    std::cout << "uniform upload, " << OBJECTS << " objects x " << MESHES_PER_OBJECT << " meshes per frame\n"
+              << "  glGetUniformLocation per set: " << beforeNanoseconds / 1000.0 << " us/frame, "
+              << callsBefore << " GL calls/frame\n"
+              << "  handles + uniform blocks:     " << afterNanoseconds / 1000.0 << " us/frame, "
+              << callsAfter << " GL calls/frame once warm\n"
+              << "  speedup: " << beforeNanoseconds / afterNanoseconds << "x" << std::endl;
+
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,138 @@
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/shader.h>
+#include <rg/GLState.h>
+#include <rg/GpuMemory.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Fixed texture slots of a material. Slot N is always bound to texture unit N, so the
+// sampler uniforms of a shader only have to be pointed at their units once.
+enum MaterialSlot {
+    MATERIAL_DIFFUSE = 0,
+    MATERIAL_SPECULAR,
+    MATERIAL_NORMAL,
+    MATERIAL_HEIGHT,
+    MATERIAL_SLOT_COUNT
+};
+
+// sampler name (without the shader prefix) each slot binds to
+inline const char* materialSamplerName(unsigned int slot)
+{
+    static const char* names[MATERIAL_SLOT_COUNT] = {
+        "texture_diffuse1", "texture_specular1", "texture_normal1", "texture_height1"
+    };
+    return names[slot];
+}
+
+// How the coverage of a material is resolved (the glTF alphaMode). Each mode is drawn in its
+// own pass: opaque with blending off, mask with discard, blend sorted back to front.
+enum AlphaMode {
+    ALPHA_OPAQUE = 0,
+    ALPHA_MASK,
+    ALPHA_BLEND
+};
+
+// A material resolved at load time: plain data, no strings, cheap to compare. Shininess is
+// not part of it, the shaders use one scene-wide value.
+struct Material {
+    unsigned int textures[MATERIAL_SLOT_COUNT]; // texture id per slot, 0 when the slot is empty
+    float diffuseFactor[4];                     // base color multiplier (rgba), material.diffuseFactor
+    AlphaMode alphaMode;
+    unsigned int id;                            // index in the MaterialLibrary, also the sort key
+};
+
+// Every distinct material of every loaded model, identical materials share one record
+// so draws can be grouped by id and skip rebinding textures between them.
+class MaterialLibrary
+{
+public:
+    // returns the id of an existing identical material or registers a new one
+    unsigned int add(Material material)
+    {
+        material.id = 0;
+        for (const Material& existing : materials)
+        {
+            if (sameContents(existing, material))
+                return existing.id;
+        }
+        material.id = (unsigned int)materials.size();
+        materials.push_back(material);
+        return material.id;
+    }
+
+    const Material& get(unsigned int id) const
+    {
+        return materials[id];
+    }
+
+    unsigned int size() const
+    {
+        return (unsigned int)materials.size();
+    }
+
+    // binds every slot of the material to its texture unit, an empty one to the slot's default
+    // texture so it doesn't sample whatever the previous mesh left there, and uploads the
+    // diffuse factor to the handle of prefix + "diffuseFactor" (-1 when the shader has none)
+    void bind(unsigned int id, Shader &shader, int diffuseFactor)
+    {
+        const Material& material = materials[id];
+        for (unsigned int slot = 0; slot < MATERIAL_SLOT_COUNT; slot++)
+        {
+            unsigned int texture = material.textures[slot] != 0 ? material.textures[slot] : defaultTexture(slot);
+            rg::glState().bindTexture(slot, GL_TEXTURE_2D, texture);
+        }
+        shader.setVec4(diffuseFactor, glm::vec4(material.diffuseFactor[0], material.diffuseFactor[1],
+                                                material.diffuseFactor[2], material.diffuseFactor[3]));
+    }
+
+private:
+    std::vector<Material> materials;
+    unsigned int defaults[MATERIAL_SLOT_COUNT] = {};
+
+    // 1x1 stand-in for an empty slot, made on first use: white diffuse, black specular,
+    // a flat normal and zero height
+    unsigned int defaultTexture(unsigned int slot)
+    {
+        if (defaults[slot] == 0)
+        {
+            static const unsigned char colors[MATERIAL_SLOT_COUNT][4] = {
+                {255, 255, 255, 255}, {0, 0, 0, 255}, {128, 128, 255, 255}, {0, 0, 0, 255}
+            };
+            glGenTextures(1, &defaults[slot]);
+            rg::glState().bindTexture(slot, GL_TEXTURE_2D, defaults[slot]);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, colors[slot]);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            rg::gpuMemory().trackTexture(defaults[slot], 1, 1, GL_RGBA, false, RG_GPU_MEMORY_SITE);
+        }
+        return defaults[slot];
+    }
+
+    static bool sameContents(const Material& a, const Material& b)
+    {
+        return std::memcmp(a.textures, b.textures, sizeof(a.textures)) == 0
+            && std::memcmp(a.diffuseFactor, b.diffuseFactor, sizeof(a.diffuseFactor)) == 0
+            && a.alphaMode == b.alphaMode;
+    }
+};
+
+inline MaterialLibrary& materialLibrary()
+{
+    static MaterialLibrary library;
+    return library;
+}
+
+// points prefix + texture_xxx1 of the shader at the fixed unit of each slot
+inline void bindMaterialSamplers(Shader &shader, const std::string &prefix)
+{
+    for (unsigned int slot = 0; slot < MATERIAL_SLOT_COUNT; slot++)
+        shader.setInt(shader.uniform(prefix + materialSamplerName(slot)), (int)slot);
+}
+
+#endif
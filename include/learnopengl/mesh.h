@@ -6,7 +6,11 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <learnopengl/material.h>
 #include <learnopengl/shader.h>
+#include <rg/FrameStats.h>
+#include <rg/GLState.h>
+#include <rg/GpuMemory.h>
 
 #include <string>
 #include <vector>
@@ -31,6 +35,7 @@ struct Texture {
     unsigned int id;
     string type;
     string path;
+    int components;
 };
 
 class Mesh {
@@ -38,65 +43,70 @@ public:
     // mesh Data
     vector<Vertex>       vertices;
     vector<unsigned int> indices;
-    vector<Texture>      textures;
+    // resolved material, see MaterialLibrary
+    unsigned int materialId;
+    // bounding box center in model space, the sort point of blended meshes
+    glm::vec3 center;
 
     unsigned int VAO;
-    std::string glslIdentifierPrefix;
     // constructor
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, unsigned int materialId)
     {
         this->vertices = vertices;
         this->indices = indices;
-        this->textures = textures;
+        this->materialId = materialId;
+        computeCenter();
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
         setupMesh();
     }
 
-    // render the mesh
-    void Draw(Shader &shader)
+    // render the mesh; expects the shader's samplers to point at the material slots (bindMaterialSamplers)
+    // and diffuseFactor to be the handle of its material.diffuseFactor
+    void Draw(Shader &shader, int diffuseFactor)
     {
-        // bind appropriate textures
-        unsigned int diffuseNr  = 1;
-        unsigned int specularNr = 1;
-        unsigned int normalNr   = 1;
-        unsigned int heightNr   = 1;
-        for(unsigned int i = 0; i < textures.size(); i++)
-        {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-            // retrieve texture number (the N in diffuse_textureN)
-            string number;
-            string name = textures[i].type;
-            if(name == "texture_diffuse")
-                number = std::to_string(diffuseNr++);
-            else if(name == "texture_specular")
-                number = std::to_string(specularNr++); // transfer unsigned int to stream
-            else if(name == "texture_normal")
-                number = std::to_string(normalNr++); // transfer unsigned int to stream
-            else if(name == "texture_height")
-                number = std::to_string(heightNr++); // transfer unsigned int to stream
-
-            // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.ID, (glslIdentifierPrefix + name + number).c_str()), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
-        }
-
+        // the state cache skips every texture the previous mesh already bound, the shader every
+        // factor it already has
+        materialLibrary().bind(materialId, shader, diffuseFactor);
 
+        DrawGeometry();
+    }
 
-        // draw mesh
-        glBindVertexArray(VAO);
+    // draws without touching textures, for depth-only passes of opaque meshes
+    void DrawGeometry()
+    {
+        // the VAO stays bound so the next draw of the same mesh skips the rebind
+        rg::glState().bindVertexArray(VAO);
         glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+        rg::countDraw(indices.size() / 3);
+    }
 
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
+    AlphaMode GetAlphaMode() const
+    {
+        return materialLibrary().get(materialId).alphaMode;
     }
 
 private:
     // render data
     unsigned int VBO, EBO;
 
+    void computeCenter()
+    {
+        if (vertices.empty())
+        {
+            center = glm::vec3(0.0f);
+            return;
+        }
+        glm::vec3 low = vertices[0].Position;
+        glm::vec3 high = vertices[0].Position;
+        for (const Vertex& vertex : vertices)
+        {
+            low = glm::min(low, vertex.Position);
+            high = glm::max(high, vertex.Position);
+        }
+        center = (low + high) * 0.5f;
+    }
+
     // initializes all the buffer objects/arrays
     void setupMesh()
     {
@@ -115,6 +125,8 @@ private:
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        rg::gpuMemory().trackBuffer(VBO, vertices.size() * sizeof(Vertex), RG_GPU_MEMORY_SITE);
+        rg::gpuMemory().trackBuffer(EBO, indices.size() * sizeof(unsigned int), RG_GPU_MEMORY_SITE);
 
         // set the vertex attribute pointers
         // vertex Positions
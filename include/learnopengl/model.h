@@ -10,18 +10,34 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include <learnopengl/material.h>
 #include <learnopengl/mesh.h>
 #include <learnopengl/shader.h>
+#include <rg/FrameStats.h>
+#include <rg/GLDebug.h>
+#include <rg/Frustum.h>
+#include <rg/Trace.h>
 
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <algorithm>
+#include <cstring>
 #include <map>
 #include <vector>
 using namespace std;
 
-unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false);
+unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false, int *components = nullptr);
+
+// which meshes of a model a draw covers
+enum MeshFilter {
+    MESHES_ALL,
+    MESHES_OPAQUE,
+    MESHES_ALPHA_TESTED,
+    MESHES_BLENDED,
+    MESHES_DEPTH_WRITING    // opaque and alpha tested, everything but blended
+};
 
 
 
@@ -33,6 +49,10 @@ public:
     vector<Mesh>    meshes;
     string directory;
     bool gammaCorrection;
+    // of every vertex, in model space
+    rg::Bounds bounds;
+    // draws and CPU time of this frame so far and of the last one (EndFrame), for the HUD
+    rg::DrawCost frameCost, lastFrameCost;
 
     // constructor, expects a filepath to a 3D model.
     Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
@@ -40,64 +60,75 @@ public:
         loadModel(path);
     }
 
-    // draws the model, and thus all its meshes
-    void Draw(Shader &shader)
+    // draws the model, and thus all its meshes (or the subset picked by filter)
+    void Draw(Shader &shader, MeshFilter filter = MESHES_ALL)
     {
+        RG_TRACE_ZONE("Model::Draw");
+        rg::DrawCostScope cost(frameCost);
+        int diffuseFactor = prepareSamplers(shader);
         for(unsigned int i = 0; i < meshes.size(); i++)
-            meshes[i].Draw(shader);
+        {
+            if (Matches(meshes[i], filter))
+                meshes[i].Draw(shader, diffuseFactor);
+        }
     }
 
-    void SetShaderTextureNamePrefix(std::string prefix) {
-        for (Mesh& mesh: meshes) {
-            mesh.glslIdentifierPrefix = prefix;
-        }
+    // draws a single mesh, used when meshes of several models are sorted together (blending)
+    void DrawMesh(Shader &shader, unsigned int index)
+    {
+        rg::DrawCostScope cost(frameCost);
+        meshes[index].Draw(shader, prepareSamplers(shader));
     }
-private:
-    // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
-    void loadModel(string const &path)
+
+    // depth-only draw of the opaque meshes, no textures are bound
+    void DrawOpaqueGeometry()
     {
-        // read file via ASSIMP
-        Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
-        // check for errors
-        if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
+        rg::DrawCostScope cost(frameCost);
+        for(unsigned int i = 0; i < meshes.size(); i++)
         {
-            cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
-            return;
+            if (meshes[i].GetAlphaMode() == ALPHA_OPAQUE)
+                meshes[i].DrawGeometry();
         }
-        // retrieve the directory path of the filepath
-        directory = path.substr(0, path.find_last_of('/'));
+    }
 
-        // process ASSIMP's root node recursively
-        processNode(scene->mRootNode, scene);
+    void EndFrame()
+    {
+        lastFrameCost = frameCost;
+        frameCost = rg::DrawCost();
     }
 
-    // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-    void processNode(aiNode *node, const aiScene *scene)
+    bool HasAlphaTestedMeshes() const
     {
-        // process each mesh located at the current node
-        for(unsigned int i = 0; i < node->mNumMeshes; i++)
-        {
-            // the node object only contains indices to index the actual objects in the scene.
-            // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
-            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.push_back(processMesh(mesh, scene));
-        }
-        // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
-        for(unsigned int i = 0; i < node->mNumChildren; i++)
+        return (alphaModes & (1u << ALPHA_MASK)) != 0;
+    }
+
+    bool HasBlendedMeshes() const
+    {
+        return (alphaModes & (1u << ALPHA_BLEND)) != 0;
+    }
+
+    static bool Matches(const Mesh &mesh, MeshFilter filter)
+    {
+        AlphaMode mode = mesh.GetAlphaMode();
+        switch (filter)
         {
-            processNode(node->mChildren[i], scene);
+            case MESHES_OPAQUE: return mode == ALPHA_OPAQUE;
+            case MESHES_ALPHA_TESTED: return mode == ALPHA_MASK;
+            case MESHES_BLENDED: return mode == ALPHA_BLEND;
+            case MESHES_DEPTH_WRITING: return mode != ALPHA_BLEND;
+            default: return true;
         }
+    }
 
+    void SetShaderTextureNamePrefix(std::string prefix) {
+        glslIdentifierPrefix = prefix;
+        samplerPrograms.clear();
     }
 
-    Mesh processMesh(aiMesh *mesh, const aiScene *scene)
+    // copies the vertices and indices of an assimp mesh into the layout Mesh uploads; no GL,
+    // public so the loader benchmark can time it on its own
+    static void ConvertMesh(const aiMesh *mesh, vector<Vertex> &vertices, vector<unsigned int> &indices)
     {
-        // data to fill
-        vector<Vertex> vertices;
-        vector<unsigned int> indices;
-        vector<Texture> textures;
-
         // walk through each of the mesh's vertices
         for(unsigned int i = 0; i < mesh->mNumVertices; i++)
         {
@@ -151,6 +182,91 @@ private:
             for(unsigned int j = 0; j < face.mNumIndices; j++)
                 indices.push_back(face.mIndices[j]);
         }
+    }
+
+private:
+    std::string glslIdentifierPrefix;
+    // bit per AlphaMode present in the model
+    unsigned int alphaModes = 0;
+    // programs whose sampler uniforms already point at the material slots, with the handle
+    // of their diffuse factor
+    struct SamplerProgram
+    {
+        unsigned int program;
+        int diffuseFactor;
+    };
+    vector<SamplerProgram> samplerPrograms;
+
+    // returns the diffuse factor handle of the shader
+    int prepareSamplers(Shader &shader)
+    {
+        for (const SamplerProgram &prepared : samplerPrograms)
+        {
+            if (prepared.program == shader.ID)
+                return prepared.diffuseFactor;
+        }
+        bindMaterialSamplers(shader, glslIdentifierPrefix);
+        samplerPrograms.push_back(SamplerProgram{shader.ID, shader.uniform(glslIdentifierPrefix + "diffuseFactor")});
+        return samplerPrograms.back().diffuseFactor;
+    }
+
+    // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
+    void loadModel(string const &path)
+    {
+        RG_TRACE_ZONE_DYNAMIC("Model::loadModel " + path);
+        // read file via ASSIMP
+        Assimp::Importer importer;
+        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        // check for errors
+        if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
+        {
+            cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
+            return;
+        }
+        // retrieve the directory path of the filepath
+        directory = path.substr(0, path.find_last_of('/'));
+        // the buffers and textures below are this model's in the GPU memory totals
+        rg::GpuMemoryOwner owner(directory.substr(directory.find_last_of('/') + 1));
+
+        // process ASSIMP's root node recursively
+        processNode(scene->mRootNode, scene);
+
+        // draw meshes that share a material back to back so their textures are bound once
+        std::stable_sort(meshes.begin(), meshes.end(), [](const Mesh& a, const Mesh& b) {
+            return a.materialId < b.materialId;
+        });
+        for (const Mesh& mesh : meshes)
+            alphaModes |= 1u << mesh.GetAlphaMode();
+    }
+
+    // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
+    void processNode(aiNode *node, const aiScene *scene)
+    {
+        // process each mesh located at the current node
+        for(unsigned int i = 0; i < node->mNumMeshes; i++)
+        {
+            // the node object only contains indices to index the actual objects in the scene.
+            // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
+            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
+            meshes.push_back(processMesh(mesh, scene));
+        }
+        // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
+        for(unsigned int i = 0; i < node->mNumChildren; i++)
+        {
+            processNode(node->mChildren[i], scene);
+        }
+
+    }
+
+    Mesh processMesh(aiMesh *mesh, const aiScene *scene)
+    {
+        // data to fill
+        vector<Vertex> vertices;
+        vector<unsigned int> indices;
+        ConvertMesh(mesh, vertices, indices);
+        for (const Vertex &vertex : vertices)
+            bounds.add(vertex.Position);
+
         // process materials
         aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
         // we assume a convention for sampler names in the shaders. Each diffuse texture should be named
@@ -163,23 +279,55 @@ private:
         material->Get(AI_MATKEY_COLOR_AMBIENT, color);
 
 
+        // resolve the material once; the shaders only sample the first texture of each kind
+        Material resolved;
+        std::memset(&resolved, 0, sizeof(resolved));
         // 1. diffuse maps
         vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-        textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+        resolved.textures[MATERIAL_DIFFUSE] = firstTexture(diffuseMaps);
+        resolved.alphaMode = resolveAlphaMode(material, diffuseMaps);
         // 2. specular maps
-        vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-        textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+        resolved.textures[MATERIAL_SPECULAR] = firstTexture(loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular"));
         // 3. normal maps
-        std::vector<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
-        textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
+        resolved.textures[MATERIAL_NORMAL] = firstTexture(loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal"));
         // 4. height maps
-        std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
-        textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
-
+        resolved.textures[MATERIAL_HEIGHT] = firstTexture(loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height"));
 
+        aiColor4D diffuse(1.0f, 1.0f, 1.0f, 1.0f);
+        material->Get(AI_MATKEY_COLOR_DIFFUSE, diffuse);
+        resolved.diffuseFactor[0] = diffuse.r;
+        resolved.diffuseFactor[1] = diffuse.g;
+        resolved.diffuseFactor[2] = diffuse.b;
+        resolved.diffuseFactor[3] = diffuse.a;
 
         // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+        return Mesh(vertices, indices, materialLibrary().add(resolved));
+    }
+
+    // glTF files state the alpha mode; for other formats an alpha channel in the diffuse map means
+    // the mesh is cut out (foliage) and a material opacity below one means it is blended
+    static AlphaMode resolveAlphaMode(aiMaterial *material, const vector<Texture> &diffuseMaps)
+    {
+        aiString gltfAlphaMode;
+        if (material->Get("$mat.gltf.alphaMode", 0, 0, gltfAlphaMode) == AI_SUCCESS)
+        {
+            if (std::strcmp(gltfAlphaMode.C_Str(), "MASK") == 0)
+                return ALPHA_MASK;
+            if (std::strcmp(gltfAlphaMode.C_Str(), "BLEND") == 0)
+                return ALPHA_BLEND;
+            return ALPHA_OPAQUE;
+        }
+        if (!diffuseMaps.empty() && diffuseMaps[0].components == 4)
+            return ALPHA_MASK;
+        float opacity = 1.0f;
+        if (material->Get(AI_MATKEY_OPACITY, opacity) == AI_SUCCESS && opacity < 1.0f)
+            return ALPHA_BLEND;
+        return ALPHA_OPAQUE;
+    }
+
+    static unsigned int firstTexture(const vector<Texture> &textures)
+    {
+        return textures.empty() ? 0 : textures[0].id;
     }
 
     // checks all material textures of a given type and loads the textures if they're not loaded yet.
@@ -205,7 +353,7 @@ private:
             if(!skip)
             {   // if texture hasn't been loaded already, load it
                 Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
+                texture.id = TextureFromFile(str.C_Str(), this->directory, false, &texture.components);
                 texture.type = typeName;
                 texture.path = str.C_Str();
                 textures.push_back(texture);
@@ -217,7 +365,7 @@ private:
 };
 
 
-unsigned int TextureFromFile(const char *path, const string &directory, bool gamma)
+unsigned int TextureFromFile(const char *path, const string &directory, bool gamma, int *components)
 {
     string filename = string(path);
     filename = directory + '/' + filename;
@@ -225,8 +373,10 @@ unsigned int TextureFromFile(const char *path, const string &directory, bool gam
     unsigned int textureID;
     glGenTextures(1, &textureID);
 
-    int width, height, nrComponents;
+    int width, height, nrComponents = 0;
     unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
+    if (components != nullptr)
+        *components = nrComponents;
     if (data)
     {
         GLenum format;
@@ -238,8 +388,10 @@ unsigned int TextureFromFile(const char *path, const string &directory, bool gam
             format = GL_RGBA;
 
         glBindTexture(GL_TEXTURE_2D, textureID);
+        RG_GL_LABEL(GL_TEXTURE, textureID, filename);
         glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
         glGenerateMipmap(GL_TEXTURE_2D);
+        rg::gpuMemory().trackTexture(textureID, width, height, format, true, RG_GPU_MEMORY_SITE);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -4,18 +4,27 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <algorithm>
+#include <cstring>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <common.h>
+#include <rg/GLDebug.h>
+#include <rg/GLState.h>
+#include <rg/UniformBlocks.h>
+
 class Shader
 {
 public:
     unsigned int ID;
     // constructor generates the shader on the fly
+    // defines (e.g. "#define ALPHA_TEST\n") are inserted right after the #version line of every stage
     // ------------------------------------------------------------------------
-    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
+    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr, const char* defines = nullptr)
     {
         std::string vertexPathString(vertexPath);
         std::string fragmentPathString(fragmentPath);
@@ -64,6 +73,12 @@ public:
         {
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
         }
+        if(defines != nullptr)
+        {
+            vertexCode = injectDefines(vertexCode, defines);
+            fragmentCode = injectDefines(fragmentCode, defines);
+            geometryCode = injectDefines(geometryCode, defines);
+        }
         const char* vShaderCode = vertexCode.c_str();
         const char * fShaderCode = fragmentCode.c_str();
         // 2. compile shaders
@@ -96,6 +111,9 @@ public:
             glAttachShader(ID, geometry);
         glLinkProgram(ID);
         checkCompileErrors(ID, "PROGRAM");
+        RG_GL_LABEL(GL_PROGRAM, ID, std::string(vertexPath) + " + " + fragmentPath);
+        reflectUniforms();
+        bindUniformBlocks();
         // delete the shaders as they're linked into our program now and no longer necessery
         glDeleteShader(vertex);
         glDeleteShader(fragment);
@@ -105,70 +123,223 @@ public:
     }
     // activate the shader
     // ------------------------------------------------------------------------
-    void use() 
-    { 
-        glUseProgram(ID); 
+    void use()
+    {
+        rg::glState().useProgram(ID);
+    }
+    // uniform handles
+    // ------------------------------------------------------------------------
+    // every active uniform is reflected once at link time; uniform() turns a name into a
+    // small integer handle that the typed setters below accept. Returns -1 for names the
+    // linker optimized away, setters silently ignore that handle like glUniform* ignores -1.
+    int uniform(const std::string &name) const
+    {
+        std::unordered_map<std::string, int>::const_iterator it = m_UniformHandles.find(name);
+        return it == m_UniformHandles.end() ? -1 : it->second;
     }
     // utility uniform functions
     // ------------------------------------------------------------------------
-    void setBool(const std::string &name, bool value) const
-    {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+    void setBool(int handle, bool value)
+    {
+        setInt(handle, (int)value);
     }
+    void setInt(int handle, int value)
+    {
+        if (UniformSlot* slot = changed(handle, &value, sizeof(value)))
+            glUniform1i(slot->location, value);
+    }
+    void setFloat(int handle, float value)
+    {
+        if (UniformSlot* slot = changed(handle, &value, sizeof(value)))
+            glUniform1f(slot->location, value);
+    }
+    void setVec2(int handle, const glm::vec2 &value)
+    {
+        if (UniformSlot* slot = changed(handle, &value[0], sizeof(float) * 2))
+            glUniform2fv(slot->location, 1, &value[0]);
+    }
+    void setVec3(int handle, const glm::vec3 &value)
+    {
+        if (UniformSlot* slot = changed(handle, &value[0], sizeof(float) * 3))
+            glUniform3fv(slot->location, 1, &value[0]);
+    }
+    void setVec4(int handle, const glm::vec4 &value)
+    {
+        if (UniformSlot* slot = changed(handle, &value[0], sizeof(float) * 4))
+            glUniform4fv(slot->location, 1, &value[0]);
+    }
+    void setMat2(int handle, const glm::mat2 &mat)
+    {
+        if (UniformSlot* slot = changed(handle, &mat[0][0], sizeof(float) * 4))
+            glUniformMatrix2fv(slot->location, 1, GL_FALSE, &mat[0][0]);
+    }
+    void setMat3(int handle, const glm::mat3 &mat)
+    {
+        if (UniformSlot* slot = changed(handle, &mat[0][0], sizeof(float) * 9))
+            glUniformMatrix3fv(slot->location, 1, GL_FALSE, &mat[0][0]);
+    }
+    void setMat4(int handle, const glm::mat4 &mat)
+    {
+        if (UniformSlot* slot = changed(handle, &mat[0][0], sizeof(float) * 16))
+            glUniformMatrix4fv(slot->location, 1, GL_FALSE, &mat[0][0]);
+    }
+    // name based setters, kept for one-off configuration; they resolve through the reflected
+    // table instead of glGetUniformLocation and share the value shadowing of the handle setters
     // ------------------------------------------------------------------------
-    void setInt(const std::string &name, int value) const
-    { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+    void setBool(const std::string &name, bool value)
+    {
+        setInt(uniform(name), (int)value);
     }
     // ------------------------------------------------------------------------
-    void setFloat(const std::string &name, float value) const
-    { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+    void setInt(const std::string &name, int value)
+    {
+        setInt(uniform(name), value);
+    }
+    // ------------------------------------------------------------------------
+    void setFloat(const std::string &name, float value)
+    {
+        setFloat(uniform(name), value);
     }
     // ------------------------------------------------------------------------
-    void setVec2(const std::string &name, const glm::vec2 &value) const
-    { 
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+    void setVec2(const std::string &name, const glm::vec2 &value)
+    {
+        setVec2(uniform(name), value);
     }
-    void setVec2(const std::string &name, float x, float y) const
-    { 
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y); 
+    void setVec2(const std::string &name, float x, float y)
+    {
+        setVec2(uniform(name), glm::vec2(x, y));
     }
     // ------------------------------------------------------------------------
-    void setVec3(const std::string &name, const glm::vec3 &value) const
-    { 
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+    void setVec3(const std::string &name, const glm::vec3 &value)
+    {
+        setVec3(uniform(name), value);
     }
-    void setVec3(const std::string &name, float x, float y, float z) const
-    { 
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z); 
+    void setVec3(const std::string &name, float x, float y, float z)
+    {
+        setVec3(uniform(name), glm::vec3(x, y, z));
     }
     // ------------------------------------------------------------------------
-    void setVec4(const std::string &name, const glm::vec4 &value) const
-    { 
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+    void setVec4(const std::string &name, const glm::vec4 &value)
+    {
+        setVec4(uniform(name), value);
     }
-    void setVec4(const std::string &name, float x, float y, float z, float w) 
-    { 
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w); 
+    void setVec4(const std::string &name, float x, float y, float z, float w)
+    {
+        setVec4(uniform(name), glm::vec4(x, y, z, w));
     }
     // ------------------------------------------------------------------------
-    void setMat2(const std::string &name, const glm::mat2 &mat) const
+    void setMat2(const std::string &name, const glm::mat2 &mat)
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setMat2(uniform(name), mat);
     }
     // ------------------------------------------------------------------------
-    void setMat3(const std::string &name, const glm::mat3 &mat) const
+    void setMat3(const std::string &name, const glm::mat3 &mat)
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setMat3(uniform(name), mat);
     }
     // ------------------------------------------------------------------------
-    void setMat4(const std::string &name, const glm::mat4 &mat) const
+    void setMat4(const std::string &name, const glm::mat4 &mat)
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setMat4(uniform(name), mat);
     }
 
 private:
+    // the #version directive has to stay the first line, defines go right below it
+    static std::string injectDefines(const std::string& code, const char* defines)
+    {
+        if (code.empty())
+            return code;
+        size_t lineEnd = code.compare(0, 8, "#version") == 0 ? code.find('\n') : std::string::npos;
+        if (lineEnd == std::string::npos)
+            return std::string(defines) + code;
+        return code.substr(0, lineEnd + 1) + defines + code.substr(lineEnd + 1);
+    }
+
+    // CPU copy of a uniform's last uploaded value, large enough for a mat4
+    struct UniformSlot
+    {
+        GLint location;
+        GLenum type;
+        bool known;
+        unsigned char value[sizeof(float) * 16];
+    };
+    std::vector<UniformSlot> m_Uniforms;
+    std::unordered_map<std::string, int> m_UniformHandles;
+
+    // returns the slot to upload to, or nullptr when the handle is invalid or the value is unchanged
+    UniformSlot* changed(int handle, const void* value, size_t size)
+    {
+        if (handle < 0 || handle >= (int)m_Uniforms.size())
+            return nullptr;
+        UniformSlot& slot = m_Uniforms[handle];
+        if (slot.known && std::memcmp(slot.value, value, size) == 0)
+            return nullptr;
+        std::memcpy(slot.value, value, size);
+        slot.known = true;
+        return &slot;
+    }
+
+    void addUniform(const std::string& name, GLint location, GLenum type)
+    {
+        if (location < 0)
+            return;
+        UniformSlot slot;
+        slot.location = location;
+        slot.type = type;
+        slot.known = false;
+        m_UniformHandles[name] = (int)m_Uniforms.size();
+        m_Uniforms.push_back(slot);
+    }
+
+    // enumerates the active uniforms of the linked program. Arrays of basic types are
+    // reported once as "name[0]", so every element gets its own slot and a plain "name" is an
+    // alias for the handle of element 0, so the two spellings share one cached value.
+    void reflectUniforms()
+    {
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<GLchar> buffer(std::max(maxLength, 1));
+        for (GLint i = 0; i < count; ++i)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(ID, (GLuint)i, (GLsizei)buffer.size(), &length, &size, &type, buffer.data());
+            std::string name(buffer.data(), length);
+            GLint location = glGetUniformLocation(ID, name.c_str());
+            if (location < 0) // members of uniform blocks have no location
+                continue;
+            addUniform(name, location, type);
+            if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+            {
+                std::string base = name.substr(0, name.size() - 3);
+                m_UniformHandles[base] = m_UniformHandles[name];
+                for (GLint element = 1; element < size; ++element)
+                {
+                    std::string elementName = base + "[" + std::to_string(element) + "]";
+                    addUniform(elementName, glGetUniformLocation(ID, elementName.c_str()), type);
+                }
+            }
+        }
+    }
+
+    // attaches the shared FrameData/LightData blocks this program declares to their fixed binding points
+    void bindUniformBlocks()
+    {
+        GLint count = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+        GLchar name[256];
+        for (GLint i = 0; i < count; ++i)
+        {
+            GLsizei length = 0;
+            glGetActiveUniformBlockName(ID, (GLuint)i, sizeof(name), &length, name);
+            int binding = rg::uniformBlockBinding(std::string(name, length));
+            if (binding >= 0)
+                glUniformBlockBinding(ID, (GLuint)i, (GLuint)binding);
+        }
+    }
+
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(GLuint shader, std::string type)
@@ -0,0 +1,158 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_BLOOM_H
+#define PROJECT_BASE_BLOOM_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <learnopengl/shader.h>
+#include <rg/GLState.h>
+#include <rg/RenderTargetPool.h>
+#include <vector>
+
+namespace rg {
+
+// Progressive downsample/upsample bloom over a chain of half-size render targets.
+// The first downsample reads the HDR scene and applies the bright-pass threshold, so
+// scene shaders don't need a second bright-color output. Each following level is a
+// 13-tap downsample of the previous one; the way back up adds a 3x3 tent upsample of
+// the smaller level onto the larger one. The blurred result ends up in level 0, which
+// the caller provides; the smaller levels are pooled render targets that only live
+// while render() runs.
+class Bloom {
+public:
+    static const unsigned int MAX_LEVELS = 8;
+
+    // tent radius of the upsample in texels of the smaller level, larger spreads the glow
+    float radius = 1.0f;
+    // luminance above which pixels start to glow, knee softens the cut-off
+    float threshold = 1.0f;
+    float knee = 0.5f;
+
+    explicit Bloom(RenderTargetPool& pool, unsigned int levels = 6)
+        : m_Pool(pool),
+          m_Downsample("resources/shaders/blur.vs", "resources/shaders/bloom_downsample.fs"),
+          m_Upsample("resources/shaders/blur.vs", "resources/shaders/bloom_upsample.fs") {
+        m_Downsample.use();
+        m_Downsample.setInt("source", 0);
+        m_DownTexelSizeLoc = m_Downsample.uniform("sourceTexelSize");
+        m_PrefilterLoc = m_Downsample.uniform("prefilter");
+        m_ThresholdLoc = m_Downsample.uniform("threshold");
+        m_KneeLoc = m_Downsample.uniform("knee");
+        m_Upsample.use();
+        m_Upsample.setInt("source", 0);
+        m_UpTexelSizeLoc = m_Upsample.uniform("sourceTexelSize");
+        m_RadiusLoc = m_Upsample.uniform("filterRadius");
+        m_Levels = clampLevels(levels);
+    }
+
+    Bloom(const Bloom&) = delete;
+    Bloom& operator=(const Bloom&) = delete;
+
+    unsigned int levels() const {
+        return m_Levels;
+    }
+
+    // levels that would be smaller than a pixel are dropped when rendering
+    void setLevels(unsigned int levels) {
+        m_Levels = clampLevels(levels);
+    }
+
+    // blurs the bright parts of the width x height sceneTexture into target, a
+    // (width / 2) x (height / 2) GL_R11F_G11F_B10F texture (see targetDesc);
+    // drawQuad draws a fullscreen quad with positions at 0 and texcoords at 1.
+    // Leaves the viewport at the full width x height and blending disabled.
+    void render(GLuint sceneTexture, GLuint target, unsigned int width, unsigned int height, void (*drawQuad)()) {
+        GLState& state = glState();
+        acquireChain(target, width, height);
+        state.disable(GL_BLEND);
+
+        m_Downsample.use();
+        m_Downsample.setFloat(m_ThresholdLoc, threshold);
+        m_Downsample.setFloat(m_KneeLoc, knee);
+        GLuint source = sceneTexture;
+        glm::vec2 sourceSize(width, height);
+        for (unsigned int i = 0; i < m_Chain.size(); i++) {
+            const Level& level = m_Chain[i];
+            state.bindFramebuffer(level.fbo);
+            glViewport(0, 0, level.width, level.height);
+            m_Downsample.setVec2(m_DownTexelSizeLoc, glm::vec2(1.0f / sourceSize.x, 1.0f / sourceSize.y));
+            m_Downsample.setBool(m_PrefilterLoc, i == 0);
+            state.bindTexture(0, GL_TEXTURE_2D, source);
+            drawQuad();
+            source = level.texture;
+            sourceSize = glm::vec2(level.width, level.height);
+        }
+
+        // every level is added onto the one above it, so the glow widens with each step up
+        m_Upsample.use();
+        m_Upsample.setFloat(m_RadiusLoc, radius);
+        state.enable(GL_BLEND);
+        state.blendFunc(GL_ONE, GL_ONE);
+        for (unsigned int i = (unsigned int)m_Chain.size() - 1; i > 0; i--) {
+            const Level& smaller = m_Chain[i];
+            const Level& target = m_Chain[i - 1];
+            state.bindFramebuffer(target.fbo);
+            glViewport(0, 0, target.width, target.height);
+            m_Upsample.setVec2(m_UpTexelSizeLoc, glm::vec2(1.0f / smaller.width, 1.0f / smaller.height));
+            state.bindTexture(0, GL_TEXTURE_2D, smaller.texture);
+            drawQuad();
+        }
+        state.disable(GL_BLEND);
+
+        glViewport(0, 0, width, height);
+        // the smaller levels are free for whatever runs next
+        for (unsigned int i = 1; i < m_Chain.size(); i++)
+            m_Pool.release(m_Chain[i].texture);
+    }
+
+    // the first level, where the result ends up
+    static RenderTargetDesc targetDesc(unsigned int width, unsigned int height) {
+        // no alpha needed, 11/11/10 float halves the bandwidth of RGBA16F
+        return RenderTargetDesc{width / 2, height / 2, GL_R11F_G11F_B10F, GL_LINEAR};
+    }
+
+private:
+    struct Level {
+        GLuint fbo;
+        GLuint texture;
+        unsigned int width;
+        unsigned int height;
+    };
+
+    static unsigned int clampLevels(unsigned int levels) {
+        if (levels < 1)
+            return 1;
+        return levels > MAX_LEVELS ? MAX_LEVELS : levels;
+    }
+
+    void acquireChain(GLuint target, unsigned int width, unsigned int height) {
+        m_Chain.clear();
+        for (unsigned int i = 0; i < m_Levels; i++) {
+            RenderTargetDesc desc = targetDesc(width, height);
+            width = desc.width;
+            height = desc.height;
+            if (width == 0 || height == 0)
+                break;
+            Level level;
+            level.width = width;
+            level.height = height;
+            level.texture = i == 0 ? target : m_Pool.acquire(desc);
+            level.fbo = m_Pool.framebuffer({level.texture});
+            m_Chain.push_back(level);
+        }
+    }
+
+    RenderTargetPool& m_Pool;
+    Shader m_Downsample;
+    Shader m_Upsample;
+    int m_DownTexelSizeLoc, m_PrefilterLoc, m_ThresholdLoc, m_KneeLoc;
+    int m_UpTexelSizeLoc, m_RadiusLoc;
+    unsigned int m_Levels;
+    std::vector<Level> m_Chain;
+};
+
+}
+#endif //PROJECT_BASE_BLOOM_H
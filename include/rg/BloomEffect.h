@@ -0,0 +1,53 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_BLOOMEFFECT_H
+#define PROJECT_BASE_BLOOMEFFECT_H
+
+#include "imgui.h"
+#include <rg/Bloom.h>
+#include <rg/Effects.h>
+
+namespace rg {
+
+// glow around the bright parts of the HDR scene, see Bloom
+class BloomEffect : public Effect {
+public:
+    explicit BloomEffect(RenderTargetPool& pool) : m_Bloom(pool) {}
+
+    const char* name() const override {
+        return "Bloom";
+    }
+
+    EffectStage stage() const override {
+        return EFFECT_STAGE_POST;
+    }
+
+    void addPasses(RenderGraph& graph, FrameResources& frame) override {
+        RGTexture scene = frame.sceneColor;
+        RGTexture bloom = graph.create("bloom", Bloom::targetDesc(frame.width, frame.height));
+        unsigned int width = frame.width, height = frame.height;
+        void (*drawQuad)() = frame.drawQuad;
+        graph.addPass("Bloom", [this, scene, bloom, width, height, drawQuad](RenderGraph::Context& context) {
+            m_Bloom.render(context.texture(scene), context.texture(bloom), width, height, drawQuad);
+        }).read(scene).write(bloom);
+        frame.bloom = bloom;
+    }
+
+    void drawSettings() override {
+        int levels = m_Bloom.levels();
+        if (ImGui::SliderInt("Levels", &levels, 1, Bloom::MAX_LEVELS))
+            m_Bloom.setLevels(levels);
+        ImGui::DragFloat("Radius", &m_Bloom.radius, 0.05, 0.5, 4.0);
+        ImGui::DragFloat("Threshold", &m_Bloom.threshold, 0.05, 0.0, 10.0);
+    }
+
+private:
+    Bloom m_Bloom;
+};
+
+static EffectRegistration<BloomEffect> bloomEffectRegistration;
+
+}
+#endif //PROJECT_BASE_BLOOMEFFECT_H
@@ -0,0 +1,138 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_CAMERAPATH_H
+#define PROJECT_BASE_CAMERAPATH_H
+
+#include <glm/glm.hpp>
+#include <learnopengl/camera.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace rg {
+
+struct CameraPose {
+    float time;         // seconds since the first pose
+    glm::vec3 position;
+    glm::vec3 front;
+    float zoom;
+};
+
+// Camera poses over time, recorded once per frame and played back at any time step. The
+// file is text, a version line and then one pose per line: time, position, front, zoom.
+// Only what the view and projection are built from is kept, like ProgramState::SaveToFile.
+class CameraPath {
+public:
+    static const int VERSION = 1;
+
+    void clear() {
+        m_Poses.clear();
+    }
+
+    bool empty() const {
+        return m_Poses.empty();
+    }
+
+    size_t size() const {
+        return m_Poses.size();
+    }
+
+    // time of the last pose, the first one is at 0
+    float duration() const {
+        return m_Poses.empty() ? 0.0f : m_Poses.back().time;
+    }
+
+    // time is any clock, it's stored relative to the first recorded pose
+    void record(float time, const Camera& camera) {
+        if (m_Poses.empty())
+            m_Start = time;
+        m_Poses.push_back(CameraPose{time - m_Start, camera.Position, camera.Front, camera.Zoom});
+    }
+
+    // puts the camera where the path is at time, interpolating between the poses around it;
+    // before the start and after the end it holds the first and last pose
+    void apply(float time, Camera& camera) const {
+        if (m_Poses.empty())
+            return;
+        std::vector<CameraPose>::const_iterator next = std::upper_bound(m_Poses.begin(), m_Poses.end(), time,
+                [](float t, const CameraPose& pose) { return t < pose.time; });
+        CameraPose pose;
+        if (next == m_Poses.begin()) {
+            pose = m_Poses.front();
+        } else if (next == m_Poses.end()) {
+            pose = m_Poses.back();
+        } else {
+            const CameraPose& previous = *(next - 1);
+            float span = next->time - previous.time;
+            float t = span > 0.0f ? (time - previous.time) / span : 1.0f;
+            pose.position = glm::mix(previous.position, next->position, t);
+            pose.front = glm::normalize(glm::mix(previous.front, next->front, t));
+            pose.zoom = previous.zoom + (next->zoom - previous.zoom) * t;
+        }
+        camera.Position = pose.position;
+        camera.Front = pose.front;
+        camera.Zoom = pose.zoom;
+        // the same as Camera::updateCameraVectors, which moving the camera relies on
+        camera.Right = glm::normalize(glm::cross(camera.Front, camera.WorldUp));
+        camera.Up = glm::normalize(glm::cross(camera.Right, camera.Front));
+        // keeps mouse look continuous if the user takes over after a replay
+        camera.Pitch = glm::degrees(std::asin(glm::clamp(pose.front.y, -1.0f, 1.0f)));
+        camera.Yaw = glm::degrees(std::atan2(pose.front.z, pose.front.x));
+    }
+
+    bool save(const std::string& path) const {
+        std::ofstream out(path);
+        if (!out)
+            return false;
+        // enough digits that a saved path plays back exactly as recorded
+        out.precision(9);
+        out << "camera-path " << VERSION << '\n';
+        for (const CameraPose& pose : m_Poses) {
+            out << pose.time << ' '
+                << pose.position.x << ' ' << pose.position.y << ' ' << pose.position.z << ' '
+                << pose.front.x << ' ' << pose.front.y << ' ' << pose.front.z << ' '
+                << pose.zoom << '\n';
+        }
+        return (bool)out;
+    }
+
+    // false with a message in error when the file is missing, of another version or has no poses
+    bool load(const std::string& path, std::string& error) {
+        std::ifstream in(path);
+        if (!in) {
+            error = "can't open " + path;
+            return false;
+        }
+        std::string magic;
+        int version = 0;
+        in >> magic >> version;
+        if (magic != "camera-path" || version != VERSION) {
+            error = path + " isn't a camera path of version " + std::to_string(VERSION);
+            return false;
+        }
+        m_Poses.clear();
+        CameraPose pose;
+        while (in >> pose.time
+                  >> pose.position.x >> pose.position.y >> pose.position.z
+                  >> pose.front.x >> pose.front.y >> pose.front.z
+                  >> pose.zoom) {
+            m_Poses.push_back(pose);
+        }
+        if (m_Poses.empty()) {
+            error = path + " has no poses";
+            return false;
+        }
+        return true;
+    }
+
+private:
+    std::vector<CameraPose> m_Poses;
+    float m_Start = 0.0f;
+};
+
+}
+#endif //PROJECT_BASE_CAMERAPATH_H
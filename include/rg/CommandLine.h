@@ -0,0 +1,160 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_COMMANDLINE_H
+#define PROJECT_BASE_COMMANDLINE_H
+
+#include <rg/FramePacing.h>
+#include <cstdlib>
+#include <string>
+
+namespace rg {
+
+// what the program was started with
+struct Options {
+    bool headless = false;          // offscreen context, no window, no input, no ImGui
+    unsigned int width = 800;       // window or offscreen target size
+    unsigned int height = 600;
+    unsigned int frames = 0;        // frames to render before exiting, 0 = until the window closes or the replay ends
+    std::string scene = "resources/program_state.txt";  // saved camera and settings to start from
+    std::string renderPath;         // "forward", "deferred" or "clustered", empty keeps the default
+    std::string output;             // PPM file the last frame is written to, headless only
+    std::string record;             // camera path file the run is recorded to
+    std::string replay;             // camera path file that drives the camera, fixed time step
+    std::string report;             // JSON file the frame statistics are written to
+    std::string glStats;            // CSV file the GL calls of every frame are written to, RG_GL_STATS builds only
+    std::string glDebug = "medium"; // least severe KHR_debug messages printed, RG_GL_DEBUG builds only
+    unsigned int vramBudget = 0;    // MB of tracked GPU memory before textures lose mip levels, 0 = no budget
+    PacingMode pacing = PACING_VSYNC;
+    unsigned int fps = 60;          // frame rate of the capped pacing mode
+    bool pipelined = false;         // update the next frame on its own thread instead of each frame on the render thread
+};
+
+inline const char* usage() {
+    return "usage: project_base [--headless] [--width W] [--height H] [--frames N]\n"
+           "                    [--scene FILE] [--path forward|deferred|clustered] [--output FILE.ppm]\n"
+           "                    [--record FILE | --replay FILE] [--report FILE.json] [--gl-stats FILE.csv]\n"
+           "                    [--gl-debug high|medium|low|notification] [--vram-budget MB]\n"
+           "                    [--pacing vsync|adaptive|uncapped|capped] [--fps N] [--pipelined]\n"
+           "  --headless  render offscreen (EGL) without a window; frames defaults to 1\n"
+           "  --scene     program state file to load the camera from\n"
+           "  --output    write the last frame as a binary PPM (headless only)\n"
+           "  --record    save the camera pose of every frame as a camera path\n"
+           "  --replay    fly a recorded camera path at a fixed 60 Hz step, then print frame statistics;\n"
+           "              frames defaults to the length of the path\n"
+           "  --report    also write the frame statistics as JSON\n"
+           "  --gl-stats  write the GL calls of every frame per entry point as CSV and print the\n"
+           "              average per frame on exit (needs a build with RG_GL_STATS)\n"
+           "  --gl-debug  least severe driver message to print, medium by default (needs RG_GL_DEBUG)\n"
+           "  --vram-budget  warn when buffers and textures go over this many MB and drop top mip\n"
+           "              levels of the largest textures to get back under\n"
+           "  --pacing    how frames are paced, vsync by default; --fps sets the rate of capped\n"
+           "  --pipelined update the next frame on its own thread while this one is submitted: the\n"
+           "              frame time is the longer of the two instead of their sum, for a frame more\n"
+           "              of input latency than the default, which updates on the render thread\n";
+}
+
+// false with a message in error for anything it doesn't understand, or with an empty
+// error when only the usage was asked for
+inline bool parseCommandLine(int argc, char** argv, Options& options, std::string& error) {
+    bool framesGiven = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            error.clear();
+            return false;
+        }
+        if (arg == "--headless") {
+            options.headless = true;
+            continue;
+        }
+        if (arg == "--pipelined") {
+            options.pipelined = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            error = "unknown option or missing value: " + arg;
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--width" || arg == "--height" || arg == "--frames" || arg == "--vram-budget" || arg == "--fps") {
+            char* end = nullptr;
+            long number = std::strtol(value.c_str(), &end, 10);
+            if (end == value.c_str() || *end != '\0' || number < 0 || (number == 0 && arg != "--frames")) {
+                error = "bad value for " + arg + ": " + value;
+                return false;
+            }
+            if (arg == "--width")
+                options.width = (unsigned int)number;
+            else if (arg == "--height")
+                options.height = (unsigned int)number;
+            else if (arg == "--vram-budget")
+                options.vramBudget = (unsigned int)number;
+            else if (arg == "--fps")
+                options.fps = (unsigned int)number;
+            else
+                options.frames = (unsigned int)number;
+            framesGiven = framesGiven || arg == "--frames";
+        } else if (arg == "--scene") {
+            options.scene = value;
+        } else if (arg == "--path") {
+            if (value != "forward" && value != "deferred" && value != "clustered") {
+                error = "unknown render path: " + value;
+                return false;
+            }
+            options.renderPath = value;
+        } else if (arg == "--pacing") {
+            if (!parsePacingMode(value, options.pacing)) {
+                error = "unknown pacing mode: " + value;
+                return false;
+            }
+        } else if (arg == "--output") {
+            options.output = value;
+        } else if (arg == "--record") {
+            options.record = value;
+        } else if (arg == "--replay") {
+            options.replay = value;
+        } else if (arg == "--report") {
+            options.report = value;
+        } else if (arg == "--gl-stats") {
+#ifndef RG_GL_STATS
+            error = "--gl-stats needs a build with the RG_GL_STATS option";
+            return false;
+#endif
+            options.glStats = value;
+        } else if (arg == "--gl-debug") {
+#ifndef RG_GL_DEBUG
+            error = "--gl-debug needs a build with the RG_GL_DEBUG option";
+            return false;
+#endif
+            if (value != "high" && value != "medium" && value != "low" && value != "notification") {
+                error = "unknown severity: " + value;
+                return false;
+            }
+            options.glDebug = value;
+        } else {
+            error = "unknown option: " + arg;
+            return false;
+        }
+    }
+    if (!options.record.empty() && !options.replay.empty()) {
+        error = "--record and --replay can't be used together";
+        return false;
+    }
+    // a replay runs as long as its path unless told otherwise
+    if (options.headless && !framesGiven && options.replay.empty())
+        options.frames = 1;
+    if (options.headless && framesGiven && options.frames == 0) {
+        error = "--headless needs at least one frame";
+        return false;
+    }
+    if (!options.headless && !options.output.empty()) {
+        error = "--output needs --headless";
+        return false;
+    }
+    return true;
+}
+
+}
+#endif //PROJECT_BASE_COMMANDLINE_H
@@ -0,0 +1,194 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_DEFERRED_H
+#define PROJECT_BASE_DEFERRED_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <learnopengl/shader.h>
+#include <rg/FrameStats.h>
+#include <rg/GLState.h>
+#include <rg/GpuMemory.h>
+#include <rg/PointLights.h>
+#include <rg/RenderTargetPool.h>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace rg {
+
+// Geometry buffer of the deferred path, 8 bytes of color per pixel plus depth:
+//   0: RG16F  world-space normal, octahedral encoded
+//   1: RGBA8  albedo, specular intensity in alpha
+//   depth: DEPTH24 texture, positions are reconstructed from it
+// The textures are transient render graph targets, created with the descriptions below.
+struct GBuffer {
+    GLuint normal = 0;
+    GLuint albedoSpecular = 0;
+    GLuint depth = 0;
+
+    static RenderTargetDesc normalDesc(unsigned int width, unsigned int height) {
+        return RenderTargetDesc{width, height, GL_RG16F, GL_NEAREST};
+    }
+
+    static RenderTargetDesc albedoSpecularDesc(unsigned int width, unsigned int height) {
+        return RenderTargetDesc{width, height, GL_RGBA8, GL_NEAREST};
+    }
+
+    static RenderTargetDesc depthDesc(unsigned int width, unsigned int height) {
+        return RenderTargetDesc{width, height, GL_DEPTH_COMPONENT24, GL_NEAREST};
+    }
+};
+
+// Lighting of the deferred path into the currently bound HDR framebuffer, whose depth
+// must hold the scene depth (see GLState::blitFramebuffer). A fullscreen pass applies the
+// directional light, the global point light and ambient occlusion; every small point light
+// is then a sphere drawn instanced with additive blending. Only back faces are drawn and
+// only where the scene lies in front of them (GL_GEQUAL), so a light shades roughly the
+// pixels its volume covers, and it still works when the camera is inside a sphere.
+class DeferredLighting {
+public:
+    float shininess = 32.0f;
+
+    DeferredLighting()
+        : m_Directional("resources/shaders/ssao.vs", "resources/shaders/deferred_directional.fs"),
+          m_Volume("resources/shaders/deferred_light.vs", "resources/shaders/deferred_light.fs") {
+        for (Shader *shader : {&m_Directional, &m_Volume}) {
+            shader->use();
+            shader->setInt("gNormal", 0);
+            shader->setInt("gAlbedoSpec", 1);
+            shader->setInt("gDepth", 2);
+        }
+        m_Directional.setInt("ambientOcclusion", 3);
+        m_DirInverseViewProjectionLoc = m_Directional.uniform("inverseViewProjection");
+        m_DirShininessLoc = m_Directional.uniform("shininess");
+        m_VolumeInverseViewProjectionLoc = m_Volume.uniform("inverseViewProjection");
+        m_VolumeShininessLoc = m_Volume.uniform("shininess");
+        createSphere();
+    }
+
+    DeferredLighting(const DeferredLighting&) = delete;
+    DeferredLighting& operator=(const DeferredLighting&) = delete;
+
+    // leaves blending off, depth writes on, GL_LEQUAL and back-face culling
+    void render(const GBuffer& gBuffer, GLuint ambientOcclusion, const std::vector<PointLightInstance>& lights,
+                const glm::mat4& inverseViewProjection, void (*drawQuad)()) {
+        GLState& state = glState();
+        state.bindTexture(0, GL_TEXTURE_2D, gBuffer.normal);
+        state.bindTexture(1, GL_TEXTURE_2D, gBuffer.albedoSpecular);
+        state.bindTexture(2, GL_TEXTURE_2D, gBuffer.depth);
+        state.bindTexture(3, GL_TEXTURE_2D, ambientOcclusion);
+
+        state.disable(GL_DEPTH_TEST);
+        state.disable(GL_BLEND);
+        m_Directional.use();
+        m_Directional.setMat4(m_DirInverseViewProjectionLoc, inverseViewProjection);
+        m_Directional.setFloat(m_DirShininessLoc, shininess);
+        drawQuad();
+
+        if (!lights.empty()) {
+            uploadInstances(lights);
+            state.enable(GL_DEPTH_TEST);
+            state.depthFunc(GL_GEQUAL);
+            state.depthMask(false);
+            state.enable(GL_CULL_FACE);
+            state.cullFace(GL_FRONT);
+            state.enable(GL_BLEND);
+            state.blendFunc(GL_ONE, GL_ONE);
+            m_Volume.use();
+            m_Volume.setMat4(m_VolumeInverseViewProjectionLoc, inverseViewProjection);
+            m_Volume.setFloat(m_VolumeShininessLoc, shininess);
+            state.bindVertexArray(m_SphereVAO);
+            glDrawElementsInstanced(GL_TRIANGLES, m_SphereIndexCount, GL_UNSIGNED_INT, 0, (GLsizei)lights.size());
+            countDraw(m_SphereIndexCount / 3, lights.size());
+            state.disable(GL_BLEND);
+            state.cullFace(GL_BACK);
+            state.depthMask(true);
+        }
+        state.enable(GL_DEPTH_TEST);
+        state.depthFunc(GL_LEQUAL);
+    }
+
+private:
+    static const unsigned int RINGS = 8;
+    static const unsigned int SEGMENTS = 12;
+
+    // low-poly unit sphere, pushed out so its flat faces still contain the real sphere
+    void createSphere() {
+        const float PI = 3.14159265359f;
+        float scale = 1.0f / (std::cos(PI / SEGMENTS) * std::cos(PI / (2.0f * RINGS)));
+        std::vector<glm::vec3> positions;
+        for (unsigned int ring = 0; ring <= RINGS; ring++) {
+            float theta = PI * ring / RINGS;
+            for (unsigned int segment = 0; segment <= SEGMENTS; segment++) {
+                float phi = 2.0f * PI * segment / SEGMENTS;
+                positions.push_back(scale * glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)));
+            }
+        }
+        std::vector<unsigned int> indices;
+        for (unsigned int ring = 0; ring < RINGS; ring++) {
+            for (unsigned int segment = 0; segment < SEGMENTS; segment++) {
+                unsigned int a = ring * (SEGMENTS + 1) + segment;
+                unsigned int b = a + SEGMENTS + 1;
+                // counter-clockwise seen from outside
+                unsigned int quad[6] = {a, a + 1, b, b, a + 1, b + 1};
+                indices.insert(indices.end(), quad, quad + 6);
+            }
+        }
+        m_SphereIndexCount = (GLsizei)indices.size();
+
+        GLuint vbo, ebo;
+        glGenVertexArrays(1, &m_SphereVAO);
+        glGenBuffers(1, &vbo);
+        glGenBuffers(1, &ebo);
+        glGenBuffers(1, &m_InstanceVBO);
+        glBindVertexArray(m_SphereVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), &positions[0], GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        gpuMemory().trackBuffer(vbo, positions.size() * sizeof(glm::vec3), RG_GPU_MEMORY_SITE, "light volumes");
+        gpuMemory().trackBuffer(ebo, indices.size() * sizeof(unsigned int), RG_GPU_MEMORY_SITE, "light volumes");
+        // per light: position + radius, color
+        glBindBuffer(GL_ARRAY_BUFFER, m_InstanceVBO);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(PointLightInstance), (void*)0);
+        glVertexAttribDivisor(1, 1);
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(PointLightInstance), (void*)offsetof(PointLightInstance, color));
+        glVertexAttribDivisor(2, 1);
+        glBindVertexArray(0);
+        glState().invalidate();
+    }
+
+    void uploadInstances(const std::vector<PointLightInstance>& lights) {
+        glBindBuffer(GL_ARRAY_BUFFER, m_InstanceVBO);
+        GLsizeiptr size = lights.size() * sizeof(PointLightInstance);
+        if (size > m_InstanceCapacity) {
+            glBufferData(GL_ARRAY_BUFFER, size, &lights[0], GL_STREAM_DRAW);
+            m_InstanceCapacity = size;
+            gpuMemory().trackBuffer(m_InstanceVBO, size, RG_GPU_MEMORY_SITE, "light volumes");
+        } else {
+            // orphan the old storage so the driver doesn't wait for last frame's draw
+            glBufferData(GL_ARRAY_BUFFER, m_InstanceCapacity, NULL, GL_STREAM_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, size, &lights[0]);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    Shader m_Directional;
+    Shader m_Volume;
+    int m_DirInverseViewProjectionLoc, m_DirShininessLoc;
+    int m_VolumeInverseViewProjectionLoc, m_VolumeShininessLoc;
+    GLuint m_SphereVAO = 0;
+    GLuint m_InstanceVBO = 0;
+    GLsizei m_SphereIndexCount = 0;
+    GLsizeiptr m_InstanceCapacity = 0;
+};
+
+}
+#endif //PROJECT_BASE_DEFERRED_H
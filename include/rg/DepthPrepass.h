@@ -0,0 +1,102 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_DEPTHPREPASS_H
+#define PROJECT_BASE_DEPTHPREPASS_H
+
+#include <glad/glad.h>
+
+namespace rg {
+
+enum DepthPrepassMode {
+    DEPTH_PREPASS_OFF = 0,
+    DEPTH_PREPASS_ON,
+    DEPTH_PREPASS_AUTO
+};
+
+// Decides whether the scene gets a depth-only pre-pass. The pass that writes depth for the
+// scene geometry (the pre-pass when it runs, the main pass otherwise) is wrapped in a
+// GL_SAMPLES_PASSED query; samples per framebuffer pixel is the overdraw the main pass would
+// shade without a pre-pass (sky pixels count as zero, so the thresholds are conservative).
+// Queries are read a few frames late so the CPU never waits.
+class DepthPrepass {
+public:
+    DepthPrepassMode mode = DEPTH_PREPASS_AUTO;
+    // AUTO switches the pre-pass on above enableOverdraw and off again below disableOverdraw
+    float enableOverdraw = 1.5f;
+    float disableOverdraw = 1.2f;
+
+    DepthPrepass() {
+        glGenQueries(QUERY_COUNT, m_Queries);
+    }
+
+    ~DepthPrepass() {
+        glDeleteQueries(QUERY_COUNT, m_Queries);
+    }
+
+    DepthPrepass(const DepthPrepass&) = delete;
+    DepthPrepass& operator=(const DepthPrepass&) = delete;
+
+    bool active() const {
+        if (mode == DEPTH_PREPASS_AUTO)
+            return m_AutoActive;
+        return mode == DEPTH_PREPASS_ON;
+    }
+
+    // wrap the depth-writing scene pass
+    void beginMeasure() {
+        m_Measuring = !m_Pending[m_Current];
+        if (m_Measuring)
+            glBeginQuery(GL_SAMPLES_PASSED, m_Queries[m_Current]);
+    }
+
+    void endMeasure(unsigned int pixels) {
+        if (m_Measuring) {
+            glEndQuery(GL_SAMPLES_PASSED);
+            m_Pending[m_Current] = true;
+            m_Pixels[m_Current] = pixels;
+        }
+        m_Current = (m_Current + 1) % QUERY_COUNT;
+        collect();
+    }
+
+    // last measured shaded samples per pixel
+    float overdraw() const {
+        return m_Overdraw;
+    }
+
+private:
+    static const unsigned int QUERY_COUNT = 4;
+
+    void collect() {
+        for (unsigned int i = 0; i < QUERY_COUNT; i++) {
+            if (!m_Pending[i])
+                continue;
+            GLint available = 0;
+            glGetQueryObjectiv(m_Queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                continue;
+            GLuint samples = 0;
+            glGetQueryObjectuiv(m_Queries[i], GL_QUERY_RESULT, &samples);
+            m_Pending[i] = false;
+            if (m_Pixels[i] > 0)
+                m_Overdraw = (float)samples / (float)m_Pixels[i];
+        }
+        if (m_AutoActive && m_Overdraw < disableOverdraw)
+            m_AutoActive = false;
+        else if (!m_AutoActive && m_Overdraw > enableOverdraw)
+            m_AutoActive = true;
+    }
+
+    GLuint m_Queries[QUERY_COUNT];
+    bool m_Pending[QUERY_COUNT] = {};
+    unsigned int m_Pixels[QUERY_COUNT] = {};
+    unsigned int m_Current = 0;
+    bool m_Measuring = false;
+    bool m_AutoActive = false;
+    float m_Overdraw = 0.0f;
+};
+
+}
+#endif //PROJECT_BASE_DEPTHPREPASS_H
@@ -0,0 +1,89 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_DYNAMICRESOLUTION_H
+#define PROJECT_BASE_DYNAMICRESOLUTION_H
+
+#include <algorithm>
+#include <cmath>
+
+namespace rg {
+
+// Picks the fraction of the framebuffer size the scene is rendered at so the GPU time of a
+// frame stays under targetMilliseconds. GPU time is taken as proportional to the pixel
+// count, so the scale moves by the square root of target / measured. The measured time is
+// smoothed, the scale only moves in steps of SCALE_STEP (every step is another set of pooled
+// targets) and, after a change, it waits for the timer results of the new size to come back
+// before judging again. It only grows back when there is clear headroom, so it settles
+// instead of flipping between two sizes.
+class DynamicResolution {
+public:
+    static const unsigned int SETTLE_FRAMES = 8;
+
+    bool enabled = true;
+    float targetMilliseconds = 16.0f;
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+    // grows only while the frame takes less than this fraction of the target
+    float growBelow = 0.8f;
+    // strength of the sharpening applied when upscaling, 0 turns it off
+    float sharpness = 0.5f;
+
+    float scale() const {
+        return m_Scale;
+    }
+
+    // fixed scale, for when the controller is off
+    void setScale(float scale) {
+        m_Scale = quantize(std::min(std::max(scale, minScale), maxScale));
+    }
+
+    float smoothedMilliseconds() const {
+        return m_Smoothed;
+    }
+
+    // size the scene renders at for a framebuffer of width x height
+    unsigned int scaled(unsigned int size) const {
+        return std::max(1u, (unsigned int)(size * m_Scale + 0.5f));
+    }
+
+    // feed the GPU time of the most recent frame whose timings came back, once per frame
+    void update(float gpuMilliseconds) {
+        if (gpuMilliseconds <= 0.0f)
+            return;
+        m_Smoothed = m_Smoothed <= 0.0f ? gpuMilliseconds : m_Smoothed + (gpuMilliseconds - m_Smoothed) * 0.2f;
+        if (!enabled)
+            return;
+        if (m_Settle > 0) {
+            --m_Settle;
+            return;
+        }
+        if (m_Smoothed <= targetMilliseconds && m_Smoothed >= targetMilliseconds * growBelow)
+            return;
+
+        float wanted = m_Scale * std::sqrt(targetMilliseconds / m_Smoothed);
+        // at most two steps at a time, the estimate is rough
+        wanted = std::min(std::max(wanted, m_Scale - 2.0f * SCALE_STEP), m_Scale + 2.0f * SCALE_STEP);
+        wanted = quantize(std::min(std::max(wanted, minScale), maxScale));
+        if (std::fabs(wanted - m_Scale) < SCALE_STEP * 0.5f)
+            return;
+        m_Scale = wanted;
+        m_Settle = SETTLE_FRAMES;
+    }
+
+private:
+    // rounds down, so a scale that just fits the budget isn't pushed over it
+    static float quantize(float scale) {
+        return std::floor(scale / SCALE_STEP + 0.001f) * SCALE_STEP;
+    }
+
+    static constexpr float SCALE_STEP = 0.05f;
+
+    float m_Scale = 1.0f;
+    float m_Smoothed = 0.0f;
+    unsigned int m_Settle = 0;
+};
+
+}
+#endif //PROJECT_BASE_DYNAMICRESOLUTION_H
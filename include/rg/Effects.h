@@ -0,0 +1,115 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_EFFECTS_H
+#define PROJECT_BASE_EFFECTS_H
+
+#include <glm/glm.hpp>
+#include <rg/RenderGraph.h>
+#include <rg/RenderTargetPool.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace rg {
+
+// where in the frame an effect adds its passes
+enum EffectStage {
+    EFFECT_STAGE_DEPTH = 0,     // the scene depth is final, nothing is shaded yet
+    EFFECT_STAGE_POST           // the HDR scene color is final, before tonemapping
+};
+
+// what the frame has to offer to effects, and where they leave their results
+struct FrameResources {
+    unsigned int width;
+    unsigned int height;
+    glm::mat4 view;
+    glm::mat4 projection;
+    void (*drawQuad)();         // fullscreen quad, positions at 0 and texcoords at 1
+
+    RGTexture sceneDepth;
+    RGTexture sceneColor;
+    // filled in by effects, left invalid when nobody produced them
+    RGTexture ambientOcclusion; // full resolution R8, 1 = unoccluded
+    RGTexture bloom;            // half resolution HDR color added on top of the scene
+};
+
+// A piece of the frame that can be switched on and off. Every frame each enabled effect
+// declares its passes on the render graph at its stage; the graph culls them when nothing
+// reads what they write. Effects register themselves (see EffectRegistration), so adding
+// one only takes including its header.
+class Effect {
+public:
+    bool enabled = true;
+
+    virtual ~Effect() = default;
+
+    virtual const char* name() const = 0;
+    virtual EffectStage stage() const = 0;
+    virtual void addPasses(RenderGraph& graph, FrameResources& frame) = 0;
+    // controls of the effect's own settings, inside its ImGui window
+    virtual void drawSettings() {}
+};
+
+class EffectRegistry {
+public:
+    typedef std::function<Effect*(RenderTargetPool&)> Factory;
+
+    void add(Factory factory) {
+        m_Factories.push_back(std::move(factory));
+    }
+
+    // creates every registered effect, once there is a GL context; in registration order
+    void instantiate(RenderTargetPool& pool) {
+        for (const Factory& factory : m_Factories)
+            m_Effects.push_back(std::unique_ptr<Effect>(factory(pool)));
+    }
+
+    // before the context goes away
+    void destroy() {
+        m_Effects.clear();
+    }
+
+    void addPasses(EffectStage stage, RenderGraph& graph, FrameResources& frame) {
+        for (const std::unique_ptr<Effect>& effect : m_Effects) {
+            if (effect->enabled && effect->stage() == stage)
+                effect->addPasses(graph, frame);
+        }
+    }
+
+    bool anyEnabled(EffectStage stage) const {
+        for (const std::unique_ptr<Effect>& effect : m_Effects) {
+            if (effect->enabled && effect->stage() == stage)
+                return true;
+        }
+        return false;
+    }
+
+    const std::vector<std::unique_ptr<Effect>>& effects() const {
+        return m_Effects;
+    }
+
+private:
+    std::vector<Factory> m_Factories;
+    std::vector<std::unique_ptr<Effect>> m_Effects;
+};
+
+inline EffectRegistry& effectRegistry() {
+    static EffectRegistry registry;
+    return registry;
+}
+
+// a static instance of this in an effect's header puts the effect in the registry; the
+// headers are meant to be included from a single translation unit
+template<typename T>
+struct EffectRegistration {
+    EffectRegistration() {
+        effectRegistry().add([](RenderTargetPool& pool) -> Effect* {
+            return new T(pool);
+        });
+    }
+};
+
+}
+#endif //PROJECT_BASE_EFFECTS_H
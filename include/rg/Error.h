@@ -11,7 +11,11 @@
 #define LOG(stream) stream << "[" << __FILE__ << ", " << __func__ << ", " << __LINE__ << "] "
 #define BREAK_IF_FALSE(x) if (!(x)) __builtin_trap()
 #define ASSERT(x, msg) do { if (!(x)) { std::cerr << msg << '\n'; BREAK_IF_FALSE(false); } } while(0)
-#define GLCALL(x) \
+// Draining glGetError around a call stalls until the GPU has caught up, so it isn't done
+// per call anymore: RG_GL_DEBUG builds get errors from the KHR_debug callback (rg/GLDebug.h),
+// release builds don't check at all. GLCALL_SYNC still polls, for chasing one call by hand.
+#define GLCALL(x) do { x; } while (0)
+#define GLCALL_SYNC(x) \
 do{ rg::clearAllOpenGlErrors(); x; BREAK_IF_FALSE(rg::wasPreviousOpenGLCallSuccessful(__FILE__, __LINE__, #x)); } while (0)
 
 namespace rg {
@@ -0,0 +1,189 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_FRAMEPACING_H
+#define PROJECT_BASE_FRAMEPACING_H
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rg {
+
+enum PacingMode {
+    PACING_VSYNC,       // swap waits for the vertical blank
+    PACING_ADAPTIVE,    // like vsync, but a late frame swaps right away and tears instead of waiting a whole refresh
+    PACING_UNCAPPED,    // no waiting at all
+    PACING_CAPPED,      // no vsync, the frame rate is held at FramePacer::targetFps by the limiter
+    PACING_MODE_COUNT
+};
+
+inline const char* pacingModeName(PacingMode mode) {
+    switch (mode) {
+        case PACING_VSYNC: return "vsync";
+        case PACING_ADAPTIVE: return "adaptive";
+        case PACING_UNCAPPED: return "uncapped";
+        case PACING_CAPPED: return "capped";
+        default: return "unknown";
+    }
+}
+
+// false for anything that isn't one of the names above
+inline bool parsePacingMode(const std::string& name, PacingMode& mode) {
+    for (int i = 0; i < PACING_MODE_COUNT; i++) {
+        if (name == pacingModeName((PacingMode)i)) {
+            mode = (PacingMode)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// What the frame loop waits on. The swap interval goes to glfwSwapInterval whenever the mode
+// changes. In the capped mode wait() holds every frame to 1 / targetFps. It is called at the
+// start of the frame, before input is read, so the frame renders the freshest input instead
+// of sitting on it until the swap. Sleeping is only as precise as the OS timer (a millisecond
+// or worse), so it sleeps until SPIN_MICROSECONDS before the deadline and spins the rest.
+class FramePacer {
+public:
+    static const int SPIN_MICROSECONDS = 2000;
+
+    PacingMode mode = PACING_VSYNC;
+    float targetFps = 60.0f;
+
+    // for glfwSwapInterval; without the tear control extension adaptive is plain vsync
+    int swapInterval(bool adaptiveSupported) const {
+        switch (mode) {
+            case PACING_VSYNC: return 1;
+            case PACING_ADAPTIVE: return adaptiveSupported ? -1 : 1;
+            default: return 0;
+        }
+    }
+
+    void wait() {
+        typedef std::chrono::steady_clock Clock;
+        Clock::time_point now = Clock::now();
+        if (mode != PACING_CAPPED || targetFps <= 0.0f) {
+            m_Deadline = now;
+            return;
+        }
+        const Clock::duration period = std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(1.0 / targetFps));
+        // a frame that ran over doesn't make the next ones hurry to catch up
+        if (now - m_Deadline > period)
+            m_Deadline = now;
+        const Clock::duration spin = std::chrono::microseconds(SPIN_MICROSECONDS);
+        while (now < m_Deadline) {
+            if (m_Deadline - now > spin)
+                std::this_thread::sleep_for(m_Deadline - now - spin);
+            else
+                std::this_thread::yield();
+            now = Clock::now();
+        }
+        m_Deadline += period;
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_Deadline;
+};
+
+// Time from the moment a frame read its input (latch()) until the GPU finished everything
+// up to and including that frame's swap (endFrame()), in milliseconds. The GPU clock at the
+// latch is read with GL_TIMESTAMP and a timestamp query is placed after the swap, so both
+// ends are on the same clock. Results are read back a few frames later without waiting.
+// The latch travels with the frame: with the update running a frame ahead (FramePipeline)
+// the input read now is only on screen after the next swap. What this misses is the
+// scan-out after the frame is done: up to one refresh more with vsync, part of one without.
+class LatencyMeter {
+public:
+    static const unsigned int QUERIES = 4;
+    static const unsigned int HISTORY = 120;
+
+    LatencyMeter() = default;
+    LatencyMeter(const LatencyMeter&) = delete;
+    LatencyMeter& operator=(const LatencyMeter&) = delete;
+
+    ~LatencyMeter() {
+        if (m_Queries[0] != 0)
+            glDeleteQueries(QUERIES, m_Queries);
+    }
+
+    // right after the input the frame renders with was read
+    GLint64 latch() const {
+        GLint64 now = 0;
+        glGetInteger64v(GL_TIMESTAMP, &now);
+        return now;
+    }
+
+    // right after the swap, with what latch() returned for the frame
+    void endFrame(GLint64 latched) {
+        if (m_Queries[0] == 0)
+            glGenQueries(QUERIES, m_Queries);
+        collect();
+        Pending& slot = m_Pending[m_Next];
+        if (slot.waiting)
+            return;     // every query still in flight, skip measuring this frame
+        glQueryCounter(m_Queries[m_Next], GL_TIMESTAMP);
+        slot.latched = latched;
+        slot.waiting = true;
+        m_Next = (m_Next + 1) % QUERIES;
+    }
+
+    // drops the measurements of the previous mode
+    void reset() {
+        m_History.clear();
+    }
+
+    float lastMilliseconds() const {
+        return m_History.empty() ? 0.0f : m_History.back();
+    }
+
+    float averageMilliseconds() const {
+        if (m_History.empty())
+            return 0.0f;
+        float total = 0.0f;
+        for (float value : m_History)
+            total += value;
+        return total / m_History.size();
+    }
+
+    float maximumMilliseconds() const {
+        return m_History.empty() ? 0.0f : *std::max_element(m_History.begin(), m_History.end());
+    }
+
+private:
+    struct Pending {
+        GLint64 latched = 0;
+        bool waiting = false;
+    };
+
+    void collect() {
+        for (unsigned int i = 0; i < QUERIES; i++) {
+            Pending& slot = m_Pending[i];
+            if (!slot.waiting)
+                continue;
+            GLint available = 0;
+            glGetQueryObjectiv(m_Queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                continue;
+            GLuint64 done = 0;
+            glGetQueryObjectui64v(m_Queries[i], GL_QUERY_RESULT, &done);
+            slot.waiting = false;
+            if (m_History.size() == HISTORY)
+                m_History.erase(m_History.begin());
+            m_History.push_back((float)(((GLint64)done - slot.latched) / 1.0e6));
+        }
+    }
+
+    GLuint m_Queries[QUERIES] = {};
+    Pending m_Pending[QUERIES];
+    unsigned int m_Next = 0;
+    std::vector<float> m_History;
+};
+
+}
+#endif //PROJECT_BASE_FRAMEPACING_H
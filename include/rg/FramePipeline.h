@@ -0,0 +1,160 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_FRAMEPIPELINE_H
+#define PROJECT_BASE_FRAMEPIPELINE_H
+
+#include <rg/Trace.h>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace rg {
+
+// Runs the CPU side of the next frame (animation, culling, sorting, whatever doesn't touch GL)
+// on an update thread while the render thread submits the current one, so a frame costs the
+// longer of the two instead of their sum. There are two Frame slots: the render thread fills
+// the inputs of next(), kick() starts the update on it and acquire() waits for it and hands it
+// over, after which the other slot is next(). Each slot belongs to exactly one thread at a time,
+// so the frame data itself is never locked; the only synchronization is the handoff at kick()
+// and acquire(), once each per frame.
+//
+// Unthreaded, kick() runs the update right away on the calling thread, for comparing and for
+// anything that wants the update and the submission of a frame back to back.
+template <typename Frame>
+class FramePipeline {
+public:
+    typedef std::function<void(Frame&)> Update;
+
+    FramePipeline(Update update, bool threaded) : m_Update(std::move(update)) {
+        setThreaded(threaded);
+    }
+
+    FramePipeline(const FramePipeline&) = delete;
+    FramePipeline& operator=(const FramePipeline&) = delete;
+
+    ~FramePipeline() {
+        setThreaded(false);
+    }
+
+    bool threaded() const {
+        return m_Thread.joinable();
+    }
+
+    // an update in flight is finished and dropped first
+    void setThreaded(bool threaded) {
+        if (threaded == this->threaded())
+            return;
+        if (m_Pending)
+            acquire();
+        if (threaded) {
+            m_Stop = false;
+            m_Thread = std::thread(&FramePipeline::run, this);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stop = true;
+        }
+        m_Wake.notify_one();
+        m_Thread.join();
+    }
+
+    // kicked and not acquired yet
+    bool pending() const {
+        return m_Pending;
+    }
+
+    // the slot the next kick() updates; its inputs go in before that
+    Frame& next() {
+        return m_Slots[m_Next];
+    }
+
+    void kick() {
+        m_Pending = true;
+        if (!threaded()) {
+            m_FinishedMilliseconds = update(m_Slots[m_Next]);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Working = &m_Slots[m_Next];
+        }
+        m_Wake.notify_one();
+    }
+
+    // the kicked slot once its update is done; the render thread's until the next acquire()
+    Frame& acquire() {
+        auto start = std::chrono::steady_clock::now();
+        if (threaded()) {
+            RG_TRACE_ZONE("FramePipeline::acquire");
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Done.wait(lock, [this] { return m_Working == nullptr; });
+            m_UpdateMilliseconds = m_FinishedMilliseconds;
+        } else {
+            m_UpdateMilliseconds = m_FinishedMilliseconds;
+        }
+        m_WaitMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        m_Pending = false;
+        Frame& frame = m_Slots[m_Next];
+        m_Next ^= 1;
+        return frame;
+    }
+
+    // how long the update of the last acquired frame took
+    float updateMilliseconds() const {
+        return m_UpdateMilliseconds;
+    }
+
+    // how long the last acquire() waited for it, zero when the update kept ahead
+    float waitMilliseconds() const {
+        return m_WaitMilliseconds;
+    }
+
+private:
+    // returns how long it took
+    float update(Frame& frame) {
+        RG_TRACE_ZONE("Update");
+        auto start = std::chrono::steady_clock::now();
+        m_Update(frame);
+        return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void run() {
+        RG_TRACE_THREAD_NAME("update");
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        for (;;) {
+            m_Wake.wait(lock, [this] { return m_Stop || m_Working != nullptr; });
+            if (m_Stop)
+                return;
+            Frame* frame = m_Working;
+            lock.unlock();
+            float milliseconds = update(*frame);
+            lock.lock();
+            m_FinishedMilliseconds = milliseconds;
+            m_Working = nullptr;
+            m_Done.notify_one();
+        }
+    }
+
+    Update m_Update;
+    Frame m_Slots[2];
+    unsigned int m_Next = 0;
+    bool m_Pending = false;
+    std::thread m_Thread;
+    std::mutex m_Mutex;
+    std::condition_variable m_Wake;
+    std::condition_variable m_Done;
+    Frame* m_Working = nullptr;     // the slot being updated, guarded by m_Mutex
+    bool m_Stop = false;
+    float m_FinishedMilliseconds = 0.0f;    // of the update that finished last, guarded by m_Mutex
+    float m_UpdateMilliseconds = 0.0f;      // copied out by acquire(), render thread only
+    float m_WaitMilliseconds = 0.0f;
+};
+
+}
+#endif //PROJECT_BASE_FRAMEPIPELINE_H
@@ -0,0 +1,176 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_FRAMESTATS_H
+#define PROJECT_BASE_FRAMESTATS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace rg {
+
+// what the current frame submitted, counted at the draw calls themselves
+struct DrawCounters {
+    unsigned long drawCalls = 0;
+    unsigned long triangles = 0;
+};
+
+inline DrawCounters& drawCounters() {
+    static DrawCounters counters;
+    return counters;
+}
+
+// what drawing one thing (a model) cost over a frame
+struct DrawCost {
+    unsigned long drawCalls = 0;
+    unsigned long triangles = 0;
+    float cpuMilliseconds = 0.0f;
+};
+
+// call next to every draw call
+inline void countDraw(unsigned long triangles, unsigned long instances = 1) {
+    DrawCounters& counters = drawCounters();
+    counters.drawCalls++;
+    counters.triangles += triangles * instances;
+}
+
+// adds the draws made and the CPU time spent during its lifetime to a DrawCost
+class DrawCostScope {
+public:
+    explicit DrawCostScope(DrawCost& cost)
+            : m_Cost(cost), m_Counters(drawCounters()), m_Start(std::chrono::steady_clock::now()) {}
+
+    ~DrawCostScope() {
+        const DrawCounters& now = drawCounters();
+        m_Cost.drawCalls += now.drawCalls - m_Counters.drawCalls;
+        m_Cost.triangles += now.triangles - m_Counters.triangles;
+        m_Cost.cpuMilliseconds += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_Start).count();
+    }
+
+    DrawCostScope(const DrawCostScope&) = delete;
+    DrawCostScope& operator=(const DrawCostScope&) = delete;
+
+private:
+    DrawCost& m_Cost;
+    DrawCounters m_Counters;
+    std::chrono::steady_clock::time_point m_Start;
+};
+
+struct Percentiles {
+    float p50, p95, p99, maximum, average;
+};
+
+// Per-frame times and draw counts over a whole run (a camera path replay, a headless
+// render), summarized when it's over. Keeps every frame, a run is minutes at most.
+class FrameStats {
+public:
+    void clear() {
+        m_Frames.clear();
+    }
+
+    size_t frames() const {
+        return m_Frames.size();
+    }
+
+    // frameMilliseconds is the wall time of the whole frame, gpuMilliseconds what the GPU
+    // profiler had for it (0 without RG_GPU_PROFILER)
+    void add(float frameMilliseconds, float gpuMilliseconds, const DrawCounters& counters) {
+        m_Frames.push_back(Frame{frameMilliseconds, gpuMilliseconds, counters.drawCalls, counters.triangles});
+    }
+
+    Percentiles frameTime() const {
+        return percentiles(&Frame::milliseconds);
+    }
+
+    Percentiles gpuTime() const {
+        return percentiles(&Frame::gpuMilliseconds);
+    }
+
+    double averageDrawCalls() const {
+        return average(&Frame::drawCalls);
+    }
+
+    double averageTriangles() const {
+        return average(&Frame::triangles);
+    }
+
+    void print(std::ostream& out) const {
+        Percentiles cpu = frameTime(), gpu = gpuTime();
+        out << m_Frames.size() << " frames\n"
+            << "frame ms  p50 " << cpu.p50 << "  p95 " << cpu.p95 << "  p99 " << cpu.p99 << "  max " << cpu.maximum
+            << "  avg " << cpu.average << '\n'
+            << "gpu ms    p50 " << gpu.p50 << "  p95 " << gpu.p95 << "  p99 " << gpu.p99 << "  max " << gpu.maximum
+            << "  avg " << gpu.average << '\n'
+            << "draw calls " << averageDrawCalls() << "  triangles " << averageTriangles() << " per frame\n";
+    }
+
+    bool writeJson(const std::string& path) const {
+        std::ofstream out(path);
+        if (!out)
+            return false;
+        out << "{\n  \"frames\": " << m_Frames.size() << ",\n";
+        writePercentiles(out, "frame_ms", frameTime());
+        writePercentiles(out, "gpu_ms", gpuTime());
+        out << "  \"draw_calls\": " << averageDrawCalls() << ",\n"
+            << "  \"triangles\": " << averageTriangles() << "\n}\n";
+        return (bool)out;
+    }
+
+private:
+    struct Frame {
+        float milliseconds;
+        float gpuMilliseconds;
+        unsigned long drawCalls;
+        unsigned long triangles;
+    };
+
+    // nearest rank, so each one is a frame that actually happened
+    Percentiles percentiles(float Frame::*field) const {
+        Percentiles result = Percentiles{0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+        if (m_Frames.empty())
+            return result;
+        std::vector<float> sorted;
+        sorted.reserve(m_Frames.size());
+        for (const Frame& frame : m_Frames)
+            sorted.push_back(frame.*field);
+        std::sort(sorted.begin(), sorted.end());
+        auto rank = [&](float p) {
+            size_t index = (size_t)std::ceil(p * sorted.size());
+            return sorted[std::min(std::max(index, (size_t)1), sorted.size()) - 1];
+        };
+        result.p50 = rank(0.50f);
+        result.p95 = rank(0.95f);
+        result.p99 = rank(0.99f);
+        result.maximum = sorted.back();
+        double total = 0.0;
+        for (float value : sorted)
+            total += value;
+        result.average = (float)(total / sorted.size());
+        return result;
+    }
+
+    double average(unsigned long Frame::*field) const {
+        if (m_Frames.empty())
+            return 0.0;
+        double total = 0.0;
+        for (const Frame& frame : m_Frames)
+            total += frame.*field;
+        return total / m_Frames.size();
+    }
+
+    static void writePercentiles(std::ostream& out, const char* name, const Percentiles& values) {
+        out << "  \"" << name << "\": {\"p50\": " << values.p50 << ", \"p95\": " << values.p95 << ", \"p99\": "
+            << values.p99 << ", \"max\": " << values.maximum << ", \"avg\": " << values.average << "},\n";
+    }
+
+    std::vector<Frame> m_Frames;
+};
+
+}
+#endif //PROJECT_BASE_FRAMESTATS_H
@@ -0,0 +1,93 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_FRUSTUM_H
+#define PROJECT_BASE_FRUSTUM_H
+
+#include <glm/glm.hpp>
+#include <cfloat>
+
+namespace rg {
+
+// axis aligned box, empty (min > max) until something is added
+struct Bounds {
+    glm::vec3 min = glm::vec3(FLT_MAX);
+    glm::vec3 max = glm::vec3(-FLT_MAX);
+
+    bool empty() const {
+        return min.x > max.x;
+    }
+
+    void add(const glm::vec3& point) {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    void add(const Bounds& other) {
+        if (other.empty())
+            return;
+        add(other.min);
+        add(other.max);
+    }
+
+    // box around this one after an affine transform, from the center and the absolute
+    // values of the matrix (Arvo), instead of transforming all eight corners
+    Bounds transformed(const glm::mat4& transform) const {
+        if (empty())
+            return *this;
+        glm::vec3 center = (min + max) * 0.5f;
+        glm::vec3 extent = (max - min) * 0.5f;
+        glm::vec3 newCenter = glm::vec3(transform * glm::vec4(center, 1.0f));
+        glm::mat3 absolute = glm::mat3(transform);
+        for (int column = 0; column < 3; column++)
+            absolute[column] = glm::abs(absolute[column]);
+        glm::vec3 newExtent = absolute * extent;
+        Bounds result;
+        result.min = newCenter - newExtent;
+        result.max = newCenter + newExtent;
+        return result;
+    }
+};
+
+// The six planes of a projection * view matrix (Gribb-Hartmann), normals pointing inwards.
+// The box test is conservative: a box outside the frustum but crossing two planes near a
+// corner counts as visible, which only costs a draw.
+class Frustum {
+public:
+    Frustum() = default;
+
+    explicit Frustum(const glm::mat4& viewProjection) {
+        // glm is column major, row i of the matrix is m[.][i]
+        glm::vec4 rows[4];
+        for (int i = 0; i < 4; i++)
+            rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+        m_Planes[0] = rows[3] + rows[0];    // left
+        m_Planes[1] = rows[3] - rows[0];    // right
+        m_Planes[2] = rows[3] + rows[1];    // bottom
+        m_Planes[3] = rows[3] - rows[1];    // top
+        m_Planes[4] = rows[3] + rows[2];    // near
+        m_Planes[5] = rows[3] - rows[2];    // far
+        for (glm::vec4& plane : m_Planes)
+            plane /= glm::length(glm::vec3(plane));
+    }
+
+    // false only when the box is entirely behind one of the planes
+    bool intersects(const Bounds& box) const {
+        for (const glm::vec4& plane : m_Planes) {
+            // the corner furthest along the plane normal
+            glm::vec3 corner = glm::vec3(plane.x >= 0.0f ? box.max.x : box.min.x,
+                                         plane.y >= 0.0f ? box.max.y : box.min.y,
+                                         plane.z >= 0.0f ? box.max.z : box.min.z);
+            if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+                return false;
+        }
+        return true;
+    }
+
+private:
+    glm::vec4 m_Planes[6];
+};
+
+}
+#endif //PROJECT_BASE_FRUSTUM_H
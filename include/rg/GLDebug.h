@@ -0,0 +1,257 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_GLDEBUG_H
+#define PROJECT_BASE_GLDEBUG_H
+
+// GL_KHR_debug for debug builds: the driver reports errors and warnings through a callback
+// instead of us polling glGetError after every call, RG_GL_DEBUG_GROUP("name") brackets
+// the commands of the enclosing block in a named group and RG_GL_LABEL names an object,
+// both of which show up in RenderDoc and apitrace captures. Performance warnings are kept
+// for the HUD as well as printed. Everything compiles to nothing unless RG_GL_DEBUG is
+// defined (the RG_GL_DEBUG CMake option, on by default for Debug builds).
+
+#ifdef RG_GL_DEBUG
+
+#include <glad/glad.h>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// glad was generated for plain 3.3 core, which doesn't have the extension
+#ifndef GL_DEBUG_OUTPUT
+#define GL_DEBUG_OUTPUT_SYNCHRONOUS 0x8242
+#define GL_DEBUG_SOURCE_API 0x8246
+#define GL_DEBUG_SOURCE_WINDOW_SYSTEM 0x8247
+#define GL_DEBUG_SOURCE_SHADER_COMPILER 0x8248
+#define GL_DEBUG_SOURCE_THIRD_PARTY 0x8249
+#define GL_DEBUG_SOURCE_APPLICATION 0x824A
+#define GL_DEBUG_SOURCE_OTHER 0x824B
+#define GL_DEBUG_TYPE_ERROR 0x824C
+#define GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR 0x824D
+#define GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR 0x824E
+#define GL_DEBUG_TYPE_PORTABILITY 0x824F
+#define GL_DEBUG_TYPE_PERFORMANCE 0x8250
+#define GL_DEBUG_TYPE_OTHER 0x8251
+#define GL_DEBUG_TYPE_MARKER 0x8268
+#define GL_DEBUG_TYPE_PUSH_GROUP 0x8269
+#define GL_DEBUG_TYPE_POP_GROUP 0x826A
+#define GL_DEBUG_SEVERITY_HIGH 0x9146
+#define GL_DEBUG_SEVERITY_MEDIUM 0x9147
+#define GL_DEBUG_SEVERITY_LOW 0x9148
+#define GL_DEBUG_SEVERITY_NOTIFICATION 0x826B
+#define GL_DEBUG_OUTPUT 0x92E0
+#define GL_BUFFER 0x82E0
+#define GL_SHADER 0x82E1
+#define GL_PROGRAM 0x82E2
+#define GL_VERTEX_ARRAY 0x8074
+#define GL_QUERY 0x82E3
+#endif
+
+namespace rg {
+
+class GLDebug {
+public:
+    typedef void (APIENTRY* Callback)(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+                                      const GLchar* message, const void* user);
+
+    // the least severe messages that get through; notifications are mostly the driver
+    // describing where it put a buffer, so medium is the default
+    enum Severity { NOTIFICATION, LOW, MEDIUM, HIGH };
+
+    static const unsigned int KEPT_WARNINGS = 16;
+
+    // call right after glad has loaded, with the same loader; false if the context has no KHR_debug
+    bool install(GLADloadproc load, Severity minimum, std::string& error) {
+        if (!hasExtension("GL_KHR_debug")) {
+            error = "the context doesn't have GL_KHR_debug";
+            return false;
+        }
+        m_MessageCallback = (MessageCallback)load("glDebugMessageCallback");
+        m_MessageControl = (MessageControl)load("glDebugMessageControl");
+        m_PushGroup = (PushGroup)load("glPushDebugGroup");
+        m_PopGroup = (PopGroup)load("glPopDebugGroup");
+        m_ObjectLabel = (ObjectLabel)load("glObjectLabel");
+        if (!m_MessageCallback || !m_MessageControl || !m_PushGroup || !m_PopGroup || !m_ObjectLabel) {
+            error = "GL_KHR_debug is advertised, but its functions didn't load";
+            m_MessageCallback = nullptr;
+            return false;
+        }
+        glEnable(GL_DEBUG_OUTPUT);
+        m_MessageCallback(&callback, this);
+        setMinimumSeverity(minimum);
+        // our own group markers would only echo back
+        m_MessageControl(GL_DEBUG_SOURCE_APPLICATION, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+        return true;
+    }
+
+    bool installed() const {
+        return m_MessageCallback != nullptr;
+    }
+
+    void setMinimumSeverity(Severity minimum) {
+        if (!installed())
+            return;
+        const GLenum severities[] = {GL_DEBUG_SEVERITY_NOTIFICATION, GL_DEBUG_SEVERITY_LOW, GL_DEBUG_SEVERITY_MEDIUM,
+                                     GL_DEBUG_SEVERITY_HIGH};
+        for (int severity = NOTIFICATION; severity <= HIGH; severity++) {
+            m_MessageControl(GL_DONT_CARE, GL_DONT_CARE, severities[severity], 0, nullptr,
+                             severity >= minimum ? GL_TRUE : GL_FALSE);
+        }
+    }
+
+    // every error and warning stops in the callback on the thread that caused it, at the
+    // cost of the driver running asynchronously; for stepping through with a debugger
+    void setSynchronous(bool synchronous) {
+        if (!installed())
+            return;
+        if (synchronous)
+            glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        else
+            glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    }
+
+    void pushGroup(const char* name) {
+        if (installed())
+            m_PushGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+    }
+
+    void popGroup() {
+        if (installed())
+            m_PopGroup();
+    }
+
+    // type is GL_TEXTURE, GL_FRAMEBUFFER, GL_PROGRAM, GL_BUFFER, ...
+    void label(GLenum type, GLuint object, const std::string& name) {
+        if (installed() && object != 0)
+            m_ObjectLabel(type, object, (GLsizei)name.size(), name.c_str());
+    }
+
+    // the latest performance warnings, oldest first
+    std::vector<std::string> performanceWarnings() const {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return std::vector<std::string>(m_Warnings.begin(), m_Warnings.end());
+    }
+
+    unsigned long performanceWarningCount() const {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_WarningCount;
+    }
+
+private:
+    typedef void (APIENTRY* MessageCallback)(Callback callback, const void* user);
+    typedef void (APIENTRY* MessageControl)(GLenum source, GLenum type, GLenum severity, GLsizei count,
+                                            const GLuint* ids, GLboolean enabled);
+    typedef void (APIENTRY* PushGroup)(GLenum source, GLuint id, GLsizei length, const GLchar* message);
+    typedef void (APIENTRY* PopGroup)();
+    typedef void (APIENTRY* ObjectLabel)(GLenum identifier, GLuint name, GLsizei length, const GLchar* label);
+
+    static bool hasExtension(const char* name) {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; i++) {
+            const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+            if (extension && std::strcmp(extension, name) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    // may run on a driver thread unless the output is synchronous
+    static void APIENTRY callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+                                  const GLchar* message, const void* user) {
+        GLDebug& debug = *(GLDebug*)user;
+        std::string text = std::string(sourceName(source)) + " " + typeName(type) + " (" + severityName(severity) +
+                           ", " + std::to_string(id) + "): " + message;
+        std::lock_guard<std::mutex> lock(debug.m_Mutex);
+        if (type == GL_DEBUG_TYPE_PERFORMANCE) {
+            debug.m_Warnings.push_back(text);
+            if (debug.m_Warnings.size() > KEPT_WARNINGS)
+                debug.m_Warnings.pop_front();
+            debug.m_WarningCount++;
+        }
+        std::cerr << "[OpenGL] " << text << std::endl;
+    }
+
+    static const char* sourceName(GLenum source) {
+        switch (source) {
+            case GL_DEBUG_SOURCE_API: return "API";
+            case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "window system";
+            case GL_DEBUG_SOURCE_SHADER_COMPILER: return "shader compiler";
+            case GL_DEBUG_SOURCE_THIRD_PARTY: return "third party";
+            case GL_DEBUG_SOURCE_APPLICATION: return "application";
+            default: return "other";
+        }
+    }
+
+    static const char* typeName(GLenum type) {
+        switch (type) {
+            case GL_DEBUG_TYPE_ERROR: return "error";
+            case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated behavior";
+            case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "undefined behavior";
+            case GL_DEBUG_TYPE_PORTABILITY: return "portability";
+            case GL_DEBUG_TYPE_PERFORMANCE: return "performance";
+            case GL_DEBUG_TYPE_MARKER: return "marker";
+            default: return "other";
+        }
+    }
+
+    static const char* severityName(GLenum severity) {
+        switch (severity) {
+            case GL_DEBUG_SEVERITY_HIGH: return "high";
+            case GL_DEBUG_SEVERITY_MEDIUM: return "medium";
+            case GL_DEBUG_SEVERITY_LOW: return "low";
+            default: return "notification";
+        }
+    }
+
+    MessageCallback m_MessageCallback = nullptr;
+    MessageControl m_MessageControl = nullptr;
+    PushGroup m_PushGroup = nullptr;
+    PopGroup m_PopGroup = nullptr;
+    ObjectLabel m_ObjectLabel = nullptr;
+    mutable std::mutex m_Mutex;
+    std::deque<std::string> m_Warnings;
+    unsigned long m_WarningCount = 0;
+};
+
+inline GLDebug& glDebug() {
+    static GLDebug debug;
+    return debug;
+}
+
+class GLDebugGroup {
+public:
+    explicit GLDebugGroup(const char* name) {
+        glDebug().pushGroup(name);
+    }
+
+    explicit GLDebugGroup(const std::string& name) : GLDebugGroup(name.c_str()) {}
+
+    ~GLDebugGroup() {
+        glDebug().popGroup();
+    }
+
+    GLDebugGroup(const GLDebugGroup&) = delete;
+    GLDebugGroup& operator=(const GLDebugGroup&) = delete;
+};
+
+}
+
+#define RG_GL_DEBUG_CONCAT_(a, b) a##b
+#define RG_GL_DEBUG_CONCAT(a, b) RG_GL_DEBUG_CONCAT_(a, b)
+#define RG_GL_DEBUG_GROUP(name) rg::GLDebugGroup RG_GL_DEBUG_CONCAT(rgDebugGroup, __LINE__)(name)
+#define RG_GL_LABEL(type, object, name) rg::glDebug().label(type, object, name)
+
+#else
+
+#define RG_GL_DEBUG_GROUP(name) do {} while (0)
+#define RG_GL_LABEL(type, object, name) do {} while (0)
+
+#endif
+
+#endif //PROJECT_BASE_GLDEBUG_H
@@ -0,0 +1,237 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_GLSTATE_H
+#define PROJECT_BASE_GLSTATE_H
+
+#include <glad/glad.h>
+
+namespace rg {
+
+// Shadows the pieces of OpenGL state the renderer touches every frame and drops
+// calls that would set a value that is already current. Code that changes this
+// state with raw gl* calls (loaders, ImGui setup) must be followed by invalidate().
+class GLState {
+public:
+    static const unsigned int MAX_TEXTURE_UNITS = 16;
+
+    struct Counters {
+        unsigned long issued = 0;
+        unsigned long skipped = 0;
+    };
+
+    GLState() {
+        invalidate();
+    }
+
+    void useProgram(GLuint program) {
+        if (check(m_Program == program))
+            return;
+        m_Program = program;
+        glUseProgram(program);
+    }
+
+    void bindVertexArray(GLuint vao) {
+        if (check(m_VertexArray == vao))
+            return;
+        m_VertexArray = vao;
+        glBindVertexArray(vao);
+    }
+
+    void bindFramebuffer(GLuint fbo) {
+        if (check(m_Framebuffer == fbo))
+            return;
+        m_Framebuffer = fbo;
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    }
+
+    // copies a region between framebuffers and leaves draw bound as the current framebuffer
+    void blitFramebuffer(GLuint read, GLuint draw, GLint width, GLint height, GLbitfield mask) {
+        ++m_Counters.issued;
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, read);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, draw);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, mask, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, draw);
+        m_Framebuffer = draw;
+    }
+
+    void activeTexture(unsigned int unit) {
+        if (check(m_ActiveUnit == unit))
+            return;
+        m_ActiveUnit = unit;
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+
+    // binds texture to the given unit, switching the active unit only when the binding changes
+    void bindTexture(unsigned int unit, GLenum target, GLuint texture) {
+        if (unit < MAX_TEXTURE_UNITS) {
+            TextureBinding& binding = m_Textures[unit];
+            if (check(binding.target == target && binding.id == texture))
+                return;
+            binding.target = target;
+            binding.id = texture;
+        } else {
+            ++m_Counters.issued;
+        }
+        activeTexture(unit);
+        glBindTexture(target, texture);
+    }
+
+    void enable(GLenum cap) {
+        setCapability(cap, true);
+    }
+
+    void disable(GLenum cap) {
+        setCapability(cap, false);
+    }
+
+    void blendFunc(GLenum src, GLenum dst) {
+        if (check(m_BlendSrc == src && m_BlendDst == dst))
+            return;
+        m_BlendSrc = src;
+        m_BlendDst = dst;
+        glBlendFunc(src, dst);
+    }
+
+    void depthFunc(GLenum func) {
+        if (check(m_DepthFunc == func))
+            return;
+        m_DepthFunc = func;
+        glDepthFunc(func);
+    }
+
+    void depthMask(bool mask) {
+        int value = mask ? 1 : 0;
+        if (check(m_DepthMask == value))
+            return;
+        m_DepthMask = value;
+        glDepthMask(mask ? GL_TRUE : GL_FALSE);
+    }
+
+    void colorMask(bool mask) {
+        int value = mask ? 1 : 0;
+        if (check(m_ColorMask == value))
+            return;
+        m_ColorMask = value;
+        GLboolean m = mask ? GL_TRUE : GL_FALSE;
+        glColorMask(m, m, m, m);
+    }
+
+    void cullFace(GLenum face) {
+        if (check(m_CullFace == face))
+            return;
+        m_CullFace = face;
+        glCullFace(face);
+    }
+
+    // forget everything we know, the next call of each kind always reaches the driver
+    void invalidate() {
+        m_Program = UNKNOWN;
+        m_VertexArray = UNKNOWN;
+        m_Framebuffer = UNKNOWN;
+        m_ActiveUnit = UNKNOWN;
+        for (TextureBinding& binding : m_Textures) {
+            binding.target = UNKNOWN;
+            binding.id = UNKNOWN;
+        }
+        for (int& capability : m_Capabilities)
+            capability = -1;
+        m_BlendSrc = UNKNOWN;
+        m_BlendDst = UNKNOWN;
+        m_DepthFunc = UNKNOWN;
+        m_DepthMask = -1;
+        m_ColorMask = -1;
+        m_CullFace = UNKNOWN;
+    }
+
+    // counters of the frame currently being recorded
+    const Counters& counters() const {
+        return m_Counters;
+    }
+
+    // counters of the last completed frame
+    const Counters& lastFrameCounters() const {
+        return m_LastFrame;
+    }
+
+    void endFrame() {
+        m_LastFrame = m_Counters;
+        m_Counters = Counters();
+    }
+
+private:
+    static const unsigned int UNKNOWN = ~0u;
+
+    enum Capability {
+        CAP_BLEND = 0,
+        CAP_DEPTH_TEST,
+        CAP_CULL_FACE,
+        CAP_STENCIL_TEST,
+        CAP_COUNT
+    };
+
+    struct TextureBinding {
+        unsigned int target;
+        unsigned int id;
+    };
+
+    // counts the call as skipped when the state already matches, issued otherwise
+    bool check(bool alreadySet) {
+        if (alreadySet)
+            ++m_Counters.skipped;
+        else
+            ++m_Counters.issued;
+        return alreadySet;
+    }
+
+    static int capabilityIndex(GLenum cap) {
+        switch (cap) {
+            case GL_BLEND: return CAP_BLEND;
+            case GL_DEPTH_TEST: return CAP_DEPTH_TEST;
+            case GL_CULL_FACE: return CAP_CULL_FACE;
+            case GL_STENCIL_TEST: return CAP_STENCIL_TEST;
+        }
+        return -1;
+    }
+
+    void setCapability(GLenum cap, bool enabled) {
+        int index = capabilityIndex(cap);
+        if (index >= 0) {
+            if (check(m_Capabilities[index] == (enabled ? 1 : 0)))
+                return;
+            m_Capabilities[index] = enabled ? 1 : 0;
+        } else {
+            ++m_Counters.issued;
+        }
+        if (enabled)
+            glEnable(cap);
+        else
+            glDisable(cap);
+    }
+
+    unsigned int m_Program;
+    unsigned int m_VertexArray;
+    unsigned int m_Framebuffer;
+    unsigned int m_ActiveUnit;
+    TextureBinding m_Textures[MAX_TEXTURE_UNITS];
+    int m_Capabilities[CAP_COUNT];
+    unsigned int m_BlendSrc;
+    unsigned int m_BlendDst;
+    unsigned int m_DepthFunc;
+    int m_DepthMask;
+    int m_ColorMask;
+    unsigned int m_CullFace;
+
+    Counters m_Counters;
+    Counters m_LastFrame;
+};
+
+// the one context this application renders with
+inline GLState& glState() {
+    static GLState state;
+    return state;
+}
+
+}
+#endif //PROJECT_BASE_GLSTATE_H
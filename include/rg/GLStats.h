@@ -0,0 +1,296 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_GLSTATS_H
+#define PROJECT_BASE_GLSTATS_H
+
+// Counts the GL calls the program makes, per entry point and per frame, and the bytes of
+// data handed to the buffer and texture uploads. install() swaps the glad function pointers
+// of the entry points in RG_GL_STATS_ENTRY_POINTS for wrappers that count and forward, so
+// everything that calls through glad (our code, GLState, the ImGui backend) is seen without
+// touching the call sites. Compiled only with RG_GL_STATS (the CMake option); without it
+// nothing is wrapped and glad calls the driver directly.
+
+#ifdef RG_GL_STATS
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// every entry point this program and the ImGui backend call through glad (checked by grepping
+// src/, include/ and imgui_impl_opengl3.cpp); one that isn't listed still works, it just
+// isn't counted
+#define RG_GL_STATS_ENTRY_POINTS(X) \
+    X(glActiveTexture) X(glAttachShader) X(glBeginQuery) X(glBindBuffer) X(glBindBufferBase) \
+    X(glBindFramebuffer) X(glBindSampler) X(glBindTexture) X(glBindVertexArray) X(glBlendEquation) \
+    X(glBlendEquationSeparate) X(glBlendFunc) X(glBlendFuncSeparate) X(glBlitFramebuffer) \
+    X(glBufferData) X(glBufferSubData) X(glCheckFramebufferStatus) X(glClear) X(glClearBufferfv) \
+    X(glClearColor) X(glColorMask) X(glCompileShader) X(glCreateProgram) X(glCreateShader) \
+    X(glCullFace) X(glDeleteBuffers) X(glDeleteFramebuffers) X(glDeleteProgram) X(glDeleteQueries) \
+    X(glDeleteShader) X(glDeleteTextures) X(glDeleteVertexArrays) X(glDepthFunc) X(glDepthMask) \
+    X(glDetachShader) X(glDisable) X(glDrawArrays) X(glDrawArraysInstanced) X(glDrawBuffer) \
+    X(glDrawBuffers) X(glDrawElements) X(glDrawElementsBaseVertex) X(glDrawElementsInstanced) \
+    X(glEnable) X(glEnableVertexAttribArray) X(glEndQuery) X(glFinish) X(glFramebufferTexture2D) \
+    X(glGenBuffers) X(glGenFramebuffers) X(glGenQueries) X(glGenTextures) X(glGenVertexArrays) \
+    X(glGenerateMipmap) X(glGetActiveUniform) X(glGetActiveUniformBlockName) X(glGetAttribLocation) \
+    X(glGetError) X(glGetInteger64v) X(glGetIntegerv) X(glGetProgramInfoLog) X(glGetProgramiv) \
+    X(glGetQueryObjectiv) X(glGetQueryObjectui64v) X(glGetQueryObjectuiv) X(glGetShaderInfoLog) \
+    X(glGetShaderiv) X(glGetString) X(glGetStringi) X(glGetTexImage) X(glGetTexLevelParameteriv) \
+    X(glGetUniformBlockIndex) X(glGetUniformLocation) X(glIsEnabled) X(glLinkProgram) \
+    X(glPixelStorei) X(glPolygonMode) X(glQueryCounter) X(glReadBuffer) X(glReadPixels) X(glScissor) \
+    X(glShaderSource) X(glTexBuffer) X(glTexImage2D) X(glTexParameteri) X(glTexSubImage2D) \
+    X(glUniform1f) X(glUniform1i) X(glUniform2f) X(glUniform2fv) X(glUniform3f) X(glUniform3fv) \
+    X(glUniform4f) X(glUniform4fv) X(glUniformBlockBinding) X(glUniformMatrix2fv) \
+    X(glUniformMatrix3fv) X(glUniformMatrix4fv) X(glUseProgram) X(glVertexAttribDivisor) \
+    X(glVertexAttribPointer) X(glViewport)
+
+namespace rg {
+
+class GLStats {
+public:
+    static const unsigned int MAX_ENTRY_POINTS = 128;
+
+    // one frame's worth, also what a whole run averages to
+    struct Frame {
+        unsigned long calls = 0;
+        unsigned long draws = 0;        // glDraw*
+        unsigned long binds = 0;        // glBind*, glUseProgram, glActiveTexture
+        unsigned long uploadBytes = 0;  // data passed to glBufferData/glBufferSubData/glTexImage2D/glTexSubImage2D
+    };
+
+    // call once, right after glad has loaded
+    void install();
+
+    // slot of a newly wrapped entry point; the name must outlive the program (the macro's literal)
+    unsigned int add(const char* name) {
+        m_Names.push_back(name);
+        m_Kinds.push_back(std::strncmp(name, "glDraw", 6) == 0 ? DRAW
+                          : std::strncmp(name, "glBind", 6) == 0 || std::strcmp(name, "glUseProgram") == 0 ||
+                            std::strcmp(name, "glActiveTexture") == 0 ? BIND : OTHER);
+        return (unsigned int)m_Names.size() - 1;
+    }
+
+    void count(unsigned int slot) {
+        m_Current[slot]++;
+    }
+
+    void countBytes(unsigned long bytes) {
+        m_CurrentBytes += bytes;
+    }
+
+    // keeps every frame's counts for writeCsv from now on; off by default so a long
+    // interactive session doesn't grow
+    void keepHistory(bool keep) {
+        m_KeepHistory = keep;
+    }
+
+    // once per frame, after the buffers were swapped
+    void endFrame() {
+        const unsigned int entryPoints = (unsigned int)m_Names.size();
+        std::copy(m_Current, m_Current + entryPoints, m_LastFrame);
+        m_LastBytes = m_CurrentBytes;
+        for (unsigned int i = 0; i < entryPoints; i++)
+            m_Totals[i] += m_Current[i];
+        m_TotalBytes += m_CurrentBytes;
+        if (m_KeepHistory) {
+            m_History.insert(m_History.end(), m_Current, m_Current + entryPoints);
+            m_HistoryBytes.push_back(m_CurrentBytes);
+        }
+        std::fill(m_Current, m_Current + entryPoints, 0u);
+        m_CurrentBytes = 0;
+        m_Frames++;
+    }
+
+    Frame lastFrame() const {
+        return summarize(m_LastFrame, (double)m_LastBytes, 1.0);
+    }
+
+    // the last finished frame, every entry point it called with a bar scaled to the busiest one
+    void printLastFrame(std::ostream& out) const {
+        printHistogram(out, m_LastFrame, (double)m_LastBytes, 1.0, "last frame");
+    }
+
+    // the same, averaged over every frame since install
+    void printAverage(std::ostream& out) const {
+        if (m_Frames == 0)
+            return;
+        printHistogram(out, m_Totals, (double)m_TotalBytes, (double)m_Frames, "average per frame");
+    }
+
+    // one row per kept frame, one column per entry point that was called at all
+    bool writeCsv(const std::string& path) const {
+        std::ofstream out(path);
+        if (!out)
+            return false;
+        const unsigned int entryPoints = (unsigned int)m_Names.size();
+        out << "frame";
+        for (unsigned int i = 0; i < entryPoints; i++)
+            if (m_Totals[i] > 0)
+                out << ',' << m_Names[i];
+        out << ",upload_bytes\n";
+        for (size_t frame = 0; frame < m_HistoryBytes.size(); frame++) {
+            out << frame;
+            for (unsigned int i = 0; i < entryPoints; i++)
+                if (m_Totals[i] > 0)
+                    out << ',' << m_History[frame * entryPoints + i];
+            out << ',' << m_HistoryBytes[frame] << '\n';
+        }
+        return (bool)out;
+    }
+
+private:
+    enum Kind { OTHER, DRAW, BIND };
+
+    Frame summarize(const unsigned long* counts, double bytes, double frames) const {
+        double calls = 0.0, draws = 0.0, binds = 0.0;
+        for (unsigned int i = 0; i < m_Names.size(); i++) {
+            calls += counts[i];
+            draws += m_Kinds[i] == DRAW ? counts[i] : 0;
+            binds += m_Kinds[i] == BIND ? counts[i] : 0;
+        }
+        Frame frame;
+        frame.calls = (unsigned long)(calls / frames + 0.5);
+        frame.draws = (unsigned long)(draws / frames + 0.5);
+        frame.binds = (unsigned long)(binds / frames + 0.5);
+        frame.uploadBytes = (unsigned long)(bytes / frames + 0.5);
+        return frame;
+    }
+
+    void printHistogram(std::ostream& out, const unsigned long* counts, double bytes, double frames,
+                        const char* title) const {
+        std::vector<unsigned int> order;
+        for (unsigned int i = 0; i < m_Names.size(); i++)
+            if (counts[i] > 0)
+                order.push_back(i);
+        std::sort(order.begin(), order.end(), [counts](unsigned int a, unsigned int b) {
+            return counts[a] > counts[b];
+        });
+        Frame frame = summarize(counts, bytes, frames);
+        out << "GL calls, " << title << ": " << frame.calls << " (" << frame.draws << " draws, " << frame.binds
+            << " binds), " << frame.uploadBytes << " bytes uploaded\n";
+        if (order.empty())
+            return;
+        const double widest = counts[order.front()] / frames;
+        for (unsigned int i : order) {
+            double value = counts[i] / frames;
+            char line[64];
+            std::snprintf(line, sizeof(line), "  %-30s %10.1f ", m_Names[i], value);
+            out << line << std::string((size_t)(40.0 * value / widest + 0.5), '#') << '\n';
+        }
+    }
+
+    std::vector<const char*> m_Names;
+    std::vector<Kind> m_Kinds;
+    unsigned long m_Current[MAX_ENTRY_POINTS] = {};
+    unsigned long m_LastFrame[MAX_ENTRY_POINTS] = {};
+    unsigned long m_Totals[MAX_ENTRY_POINTS] = {};
+    unsigned long m_CurrentBytes = 0, m_LastBytes = 0, m_TotalBytes = 0;
+    unsigned long m_Frames = 0;
+    bool m_KeepHistory = false;
+    std::vector<unsigned long> m_History;
+    std::vector<unsigned long> m_HistoryBytes;
+};
+
+inline GLStats& glStats() {
+    static GLStats stats;
+    return stats;
+}
+
+// bytes of pixel data for a width x height upload in the given client format and type
+inline unsigned long pixelBytes(GLsizei width, GLsizei height, GLenum format, GLenum type) {
+    unsigned long channels = format == GL_RED || format == GL_DEPTH_COMPONENT ? 1
+                             : format == GL_RG ? 2
+                             : format == GL_RGB || format == GL_BGR ? 3 : 4;
+    unsigned long size = type == GL_FLOAT || type == GL_UNSIGNED_INT ? 4
+                         : type == GL_HALF_FLOAT || type == GL_UNSIGNED_SHORT ? 2 : 1;
+    return (unsigned long)width * height * channels * size;
+}
+
+// The bytes an upload call passes; 0 for every entry point but the four that take data.
+// A null data pointer only allocates, so it isn't counted.
+template <typename Function, Function* Pointer>
+struct GLUploadBytes {
+    template <typename... Args>
+    static unsigned long of(Args...) {
+        return 0;
+    }
+};
+
+template <>
+struct GLUploadBytes<PFNGLBUFFERDATAPROC, &glad_glBufferData> {
+    static unsigned long of(GLenum, GLsizeiptr size, const void* data, GLenum) {
+        return data ? (unsigned long)size : 0;
+    }
+};
+
+template <>
+struct GLUploadBytes<PFNGLBUFFERSUBDATAPROC, &glad_glBufferSubData> {
+    static unsigned long of(GLenum, GLintptr, GLsizeiptr size, const void* data) {
+        return data ? (unsigned long)size : 0;
+    }
+};
+
+template <>
+struct GLUploadBytes<PFNGLTEXIMAGE2DPROC, &glad_glTexImage2D> {
+    static unsigned long of(GLenum, GLint, GLint, GLsizei width, GLsizei height, GLint, GLenum format, GLenum type,
+                            const void* data) {
+        return data ? pixelBytes(width, height, format, type) : 0;
+    }
+};
+
+template <>
+struct GLUploadBytes<PFNGLTEXSUBIMAGE2DPROC, &glad_glTexSubImage2D> {
+    static unsigned long of(GLenum, GLint, GLint, GLint, GLsizei width, GLsizei height, GLenum format, GLenum type,
+                            const void* data) {
+        return data ? pixelBytes(width, height, format, type) : 0;
+    }
+};
+
+// The wrapper of one entry point, told apart by the address of its glad pointer
+template <typename Function, Function* Pointer>
+struct GLHook;
+
+template <typename Result, typename... Args, Result (APIENTRYP* Pointer)(Args...)>
+struct GLHook<Result (APIENTRYP)(Args...), Pointer> {
+    static Result (APIENTRYP original)(Args...);
+    static unsigned int slot;
+
+    static Result APIENTRY call(Args... args) {
+        GLStats& stats = glStats();
+        stats.count(slot);
+        stats.countBytes(GLUploadBytes<Result (APIENTRYP)(Args...), Pointer>::of(args...));
+        return original(args...);
+    }
+
+    static void install(const char* name) {
+        // not loaded (an older context), or already wrapped
+        if (*Pointer == nullptr || *Pointer == &call)
+            return;
+        original = *Pointer;
+        slot = glStats().add(name);
+        *Pointer = &call;
+    }
+};
+
+template <typename Result, typename... Args, Result (APIENTRYP* Pointer)(Args...)>
+Result (APIENTRYP GLHook<Result (APIENTRYP)(Args...), Pointer>::original)(Args...) = nullptr;
+
+template <typename Result, typename... Args, Result (APIENTRYP* Pointer)(Args...)>
+unsigned int GLHook<Result (APIENTRYP)(Args...), Pointer>::slot = 0;
+
+inline void GLStats::install() {
+#define RG_GL_STATS_HOOK(name) GLHook<decltype(glad_##name), &glad_##name>::install(#name);
+    RG_GL_STATS_ENTRY_POINTS(RG_GL_STATS_HOOK)
+#undef RG_GL_STATS_HOOK
+}
+
+}
+
+#endif //RG_GL_STATS
+#endif //PROJECT_BASE_GLSTATS_H
@@ -0,0 +1,348 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_GPUMEMORY_H
+#define PROJECT_BASE_GPUMEMORY_H
+
+#include <glad/glad.h>
+#include <rg/GLState.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define RG_GPU_MEMORY_STRINGIFY_(x) #x
+#define RG_GPU_MEMORY_STRINGIFY(x) RG_GPU_MEMORY_STRINGIFY_(x)
+// where a resource was created, for GpuMemory::track
+#define RG_GPU_MEMORY_SITE __FILE__ ":" RG_GPU_MEMORY_STRINGIFY(__LINE__)
+
+namespace rg {
+
+// bytes of one texel of an internal format, sized or not; what the driver really allocates
+// can be more (RGB is usually padded to four bytes)
+inline unsigned int bytesPerPixel(GLenum format) {
+    switch (format) {
+        case GL_RED:
+        case GL_R8: return 1;
+        case GL_RG:
+        case GL_RG8:
+        case GL_R16F: return 2;
+        case GL_RGB:
+        case GL_RGB8:
+        case GL_SRGB8: return 3;
+        case GL_RG16F:
+        case GL_RGBA:
+        case GL_RGBA8:
+        case GL_R11F_G11F_B10F:
+        case GL_R32F:
+        case GL_DEPTH_COMPONENT24:
+        case GL_DEPTH24_STENCIL8:
+        case GL_DEPTH_COMPONENT32F: return 4;
+        case GL_RGB16F: return 6;
+        case GL_RGBA16F: return 8;
+        case GL_RGBA32F: return 16;
+    }
+    return 4;
+}
+
+// a full mip chain adds a third to the top level
+inline size_t textureBytes(unsigned int width, unsigned int height, GLenum format, bool mipmapped) {
+    size_t bytes = (size_t)width * height * bytesPerPixel(format);
+    return mipmapped ? bytes * 4 / 3 : bytes;
+}
+
+// Bookkeeping of the GL buffers, textures and renderbuffers alive: size, format, the asset
+// that owns each one and where it was created, totals per kind and per asset. Sizes are what
+// was asked for at creation, not what the driver reports. With a budget set, checkBudget()
+// warns once each time the total goes over it and drops the top mip level of the largest
+// mipmapped textures (the model textures) until it is back under, or nothing is left to drop.
+class GpuMemory {
+public:
+    enum Kind { BUFFER, TEXTURE, RENDERBUFFER, KIND_COUNT };
+
+    // textures this size or smaller keep their top level
+    static const unsigned int MIN_DOWNGRADE_SIZE = 128;
+
+    struct Resource {
+        Kind kind;
+        GLuint object;
+        size_t bytes;
+        GLenum format;          // internal format, 0 for buffers
+        unsigned int width, height;
+        bool mipmapped;
+        unsigned int droppedMips;
+        std::string owner;
+        const char* site;       // RG_GPU_MEMORY_SITE
+    };
+
+    // a buffer created or resized with glBufferData
+    void trackBuffer(GLuint buffer, size_t bytes, const char* site, const std::string& owner = std::string()) {
+        track(Resource{BUFFER, buffer, bytes, 0, 0, 0, false, 0, ownerOr(owner), site});
+    }
+
+    // a 2D (or cube, with six faces in bytes) texture, or a renderbuffer
+    void trackTexture(GLuint texture, unsigned int width, unsigned int height, GLenum format, bool mipmapped,
+                      const char* site, const std::string& owner = std::string(), unsigned int faces = 1) {
+        track(Resource{TEXTURE, texture, textureBytes(width, height, format, mipmapped) * faces, format, width, height,
+                       mipmapped && faces == 1, 0, ownerOr(owner), site});
+    }
+
+    void trackRenderbuffer(GLuint renderbuffer, unsigned int width, unsigned int height, GLenum format,
+                           const char* site, const std::string& owner = std::string()) {
+        track(Resource{RENDERBUFFER, renderbuffer, textureBytes(width, height, format, false), format, width, height,
+                       false, 0, ownerOr(owner), site});
+    }
+
+    // call next to the glDelete*
+    void release(Kind kind, GLuint object) {
+        auto found = m_Resources.find(std::make_pair(kind, object));
+        if (found == m_Resources.end())
+            return;
+        m_Totals[kind] -= found->second.bytes;
+        uncharge(found->second.owner, found->second.bytes);
+        m_Resources.erase(found);
+    }
+
+    // resources tracked without an owner while this is set belong to it (see GpuMemoryOwner)
+    void setCurrentOwner(const std::string& owner) {
+        m_CurrentOwner = owner;
+    }
+
+    const std::string& currentOwner() const {
+        return m_CurrentOwner;
+    }
+
+    size_t total() const {
+        size_t total = 0;
+        for (size_t bytes : m_Totals)
+            total += bytes;
+        return total;
+    }
+
+    size_t total(Kind kind) const {
+        return m_Totals[kind];
+    }
+
+    // assets by the memory they hold, largest first; sorted again only after the totals changed,
+    // so the HUD can ask every frame
+    const std::vector<std::pair<std::string, size_t>>& byOwner() const {
+        if (m_OwnersChanged) {
+            m_ByOwner.clear();
+            for (const auto& owner : m_Owners)
+                m_ByOwner.push_back(std::make_pair(owner.first, owner.second.bytes));
+            std::sort(m_ByOwner.begin(), m_ByOwner.end(), [](const std::pair<std::string, size_t>& a,
+                                                             const std::pair<std::string, size_t>& b) {
+                return a.second > b.second;
+            });
+            m_OwnersChanged = false;
+        }
+        return m_ByOwner;
+    }
+
+    std::vector<Resource> resources() const {
+        std::vector<Resource> all;
+        all.reserve(m_Resources.size());
+        for (const auto& entry : m_Resources)
+            all.push_back(entry.second);
+        return all;
+    }
+
+    // 0 turns it off
+    void setBudget(size_t bytes) {
+        m_Budget = bytes;
+        m_OverBudget = false;
+    }
+
+    size_t budget() const {
+        return m_Budget;
+    }
+
+    bool overBudget() const {
+        return m_Budget > 0 && total() > m_Budget;
+    }
+
+    unsigned int droppedMipLevels() const {
+        return m_DroppedMips;
+    }
+
+    // once a frame is enough; does nothing while under the budget, so it's cheap
+    void checkBudget(std::ostream& log) {
+        if (!overBudget()) {
+            m_OverBudget = false;
+            return;
+        }
+        if (m_OverBudget)
+            return;
+        m_OverBudget = true;
+        log << "GPU memory " << megabytes(total()) << " is over the budget of " << megabytes(m_Budget) << ":";
+        for (const auto& owner : byOwner())
+            log << ' ' << owner.first << ' ' << megabytes(owner.second) << ',';
+        log << " dropping top mip levels" << std::endl;
+        unsigned int dropped = downgrade(m_Budget);
+        log << "Dropped " << dropped << " mip levels, GPU memory is " << megabytes(total())
+            << (overBudget() ? ", still over the budget" : "") << std::endl;
+    }
+
+    // Drops the top level of the largest mipmapped texture, one at a time, until the total is
+    // at most target bytes. Reads the remaining levels back and specifies them again one level
+    // up, so the texture keeps its name and every material using it sees the smaller one.
+    // Stalls on the readback; meant for reacting to the budget, not for every frame.
+    unsigned int downgrade(size_t target) {
+        unsigned int dropped = 0;
+        while (total() > target) {
+            Resource* largest = nullptr;
+            for (auto& entry : m_Resources) {
+                Resource& resource = entry.second;
+                if (resource.kind == TEXTURE && resource.mipmapped &&
+                    std::max(resource.width, resource.height) > MIN_DOWNGRADE_SIZE &&
+                    (largest == nullptr || resource.bytes > largest->bytes))
+                    largest = &resource;
+            }
+            if (largest == nullptr || !dropTopMip(*largest))
+                break;
+            dropped++;
+        }
+        m_DroppedMips += dropped;
+        return dropped;
+    }
+
+private:
+    typedef std::pair<Kind, GLuint> Key;
+
+    // what one owner holds; the owner goes away with its last resource
+    struct OwnerTotal {
+        size_t bytes = 0;
+        unsigned int resources = 0;
+    };
+
+    void track(const Resource& resource) {
+        Key key = std::make_pair(resource.kind, resource.object);
+        auto found = m_Resources.find(key);
+        if (found != m_Resources.end()) {
+            m_Totals[resource.kind] -= found->second.bytes;
+            uncharge(found->second.owner, found->second.bytes);
+        }
+        m_Resources[key] = resource;
+        m_Totals[resource.kind] += resource.bytes;
+        charge(resource.owner, resource.bytes);
+    }
+
+    void charge(const std::string& owner, size_t bytes) {
+        OwnerTotal& total = m_Owners[owner];
+        total.bytes += bytes;
+        total.resources++;
+        m_OwnersChanged = true;
+    }
+
+    void uncharge(const std::string& owner, size_t bytes) {
+        auto found = m_Owners.find(owner);
+        found->second.bytes -= bytes;
+        if (--found->second.resources == 0)
+            m_Owners.erase(found);
+        m_OwnersChanged = true;
+    }
+
+    static std::string megabytes(size_t bytes) {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.1f MB", bytes / (1024.0 * 1024.0));
+        return text;
+    }
+
+    std::string ownerOr(const std::string& owner) const {
+        if (!owner.empty())
+            return owner;
+        return m_CurrentOwner.empty() ? std::string("other") : m_CurrentOwner;
+    }
+
+    static GLenum transferFormat(GLenum format) {
+        switch (format) {
+            case GL_RED:
+            case GL_R8: return GL_RED;
+            case GL_RG:
+            case GL_RG8: return GL_RG;
+            case GL_RGB:
+            case GL_RGB8:
+            case GL_SRGB8: return GL_RGB;
+        }
+        return GL_RGBA;
+    }
+
+    bool dropTopMip(Resource& resource) {
+        const GLenum format = transferFormat(resource.format);
+        const unsigned int channels = format == GL_RED ? 1 : format == GL_RG ? 2 : format == GL_RGB ? 3 : 4;
+        const unsigned int levels = (unsigned int)std::floor(std::log2((double)std::max(resource.width, resource.height))) + 1;
+        if (levels < 2)
+            return false;
+
+        glBindTexture(GL_TEXTURE_2D, resource.object);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        std::vector<unsigned char> pixels;
+        for (unsigned int level = 1; level < levels; level++) {
+            unsigned int width = std::max(resource.width >> level, 1u);
+            unsigned int height = std::max(resource.height >> level, 1u);
+            pixels.resize((size_t)width * height * channels);
+            glGetTexImage(GL_TEXTURE_2D, level, format, GL_UNSIGNED_BYTE, pixels.data());
+            glTexImage2D(GL_TEXTURE_2D, level - 1, resource.format, width, height, 0, format, GL_UNSIGNED_BYTE,
+                         pixels.data());
+        }
+        // the old smallest level is still there, one past the end of the new chain
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 2);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glState().invalidate();
+
+        m_Totals[TEXTURE] -= resource.bytes;
+        m_Owners[resource.owner].bytes -= resource.bytes;
+        resource.width = std::max(resource.width >> 1, 1u);
+        resource.height = std::max(resource.height >> 1, 1u);
+        resource.bytes = textureBytes(resource.width, resource.height, resource.format, true);
+        resource.droppedMips++;
+        m_Totals[TEXTURE] += resource.bytes;
+        m_Owners[resource.owner].bytes += resource.bytes;
+        m_OwnersChanged = true;
+        return true;
+    }
+
+    std::map<Key, Resource> m_Resources;
+    size_t m_Totals[KIND_COUNT] = {};
+    std::map<std::string, OwnerTotal> m_Owners;
+    mutable std::vector<std::pair<std::string, size_t>> m_ByOwner;  // m_Owners sorted, see byOwner()
+    mutable bool m_OwnersChanged = false;
+    std::string m_CurrentOwner;
+    size_t m_Budget = 0;
+    bool m_OverBudget = false;
+    unsigned int m_DroppedMips = 0;
+};
+
+inline GpuMemory& gpuMemory() {
+    static GpuMemory memory;
+    return memory;
+}
+
+// resources created during its lifetime without an explicit owner are charged to name
+class GpuMemoryOwner {
+public:
+    explicit GpuMemoryOwner(const std::string& name) : m_Previous(gpuMemory().currentOwner()) {
+        gpuMemory().setCurrentOwner(name);
+    }
+
+    ~GpuMemoryOwner() {
+        gpuMemory().setCurrentOwner(m_Previous);
+    }
+
+    GpuMemoryOwner(const GpuMemoryOwner&) = delete;
+    GpuMemoryOwner& operator=(const GpuMemoryOwner&) = delete;
+
+private:
+    std::string m_Previous;
+};
+
+}
+#endif //PROJECT_BASE_GPUMEMORY_H
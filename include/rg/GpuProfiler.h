@@ -0,0 +1,222 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_GPUPROFILER_H
+#define PROJECT_BASE_GPUPROFILER_H
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#ifdef RG_GPU_PROFILER
+#include <algorithm>
+#include <fstream>
+#include <map>
+#endif
+
+namespace rg {
+
+struct GpuTimerStats {
+    std::string name;
+    float last;         // newest result
+    float minimum;      // over the last GpuProfiler::HISTORY results
+    float average;
+    float maximum;
+    unsigned int samples;
+};
+
+#ifdef RG_GPU_PROFILER
+
+// GPU time of named scopes (render passes, ImGui), measured with GL_TIME_ELAPSED queries.
+// The queries of a frame are read back LATENCY_FRAMES frames later, when they are done, so
+// reading never waits on the GPU; a result that still isn't there by then is dropped.
+// Scopes can't nest, GL allows one GL_TIME_ELAPSED query at a time. Built with the
+// RG_GPU_PROFILER option, otherwise every call below compiles to nothing.
+class GpuProfiler {
+public:
+    static const unsigned int LATENCY_FRAMES = 4;
+    static const unsigned int HISTORY = 120;
+
+    GpuProfiler() = default;
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+    // call once per frame before the first scope
+    void beginFrame() {
+        ++m_Frame;
+        std::vector<Pending>& pending = m_Pending[m_Frame % LATENCY_FRAMES];
+        for (const Pending& timed : pending) {
+            GLint available = 0;
+            glGetQueryObjectiv(timed.query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available) {
+                GLuint64 nanoseconds = 0;
+                glGetQueryObjectui64v(timed.query, GL_QUERY_RESULT, &nanoseconds);
+                m_Timers[timed.timer].add((float)(nanoseconds / 1.0e6));
+            }
+            m_FreeQueries.push_back(timed.query);
+        }
+        pending.clear();
+    }
+
+    void begin(const std::string& name) {
+        GLuint query = takeQuery();
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        m_Pending[m_Frame % LATENCY_FRAMES].push_back(Pending{timer(name), query});
+    }
+
+    void end() {
+        glEndQuery(GL_TIME_ELAPSED);
+    }
+
+    // newest result of the scope, 0 until one came back
+    float lastMilliseconds(const std::string& name) const {
+        std::map<std::string, unsigned int>::const_iterator it = m_Index.find(name);
+        return it == m_Index.end() ? 0.0f : m_Timers[it->second].last;
+    }
+
+    // every scope seen so far, in the order they first ran
+    std::vector<GpuTimerStats> stats() const {
+        std::vector<GpuTimerStats> result;
+        for (const Timer& timer : m_Timers)
+            result.push_back(timer.stats());
+        return result;
+    }
+
+    bool writeCsv(const std::string& path) const {
+        std::ofstream out(path);
+        if (!out)
+            return false;
+        out << "pass,last_ms,min_ms,avg_ms,max_ms,samples\n";
+        for (const GpuTimerStats& timer : stats()) {
+            out << timer.name << ',' << timer.last << ',' << timer.minimum << ',' << timer.average << ','
+                << timer.maximum << ',' << timer.samples << '\n';
+        }
+        return (bool)out;
+    }
+
+    bool writeJson(const std::string& path) const {
+        std::ofstream out(path);
+        if (!out)
+            return false;
+        out << "{\n  \"passes\": [";
+        std::vector<GpuTimerStats> timers = stats();
+        for (unsigned int i = 0; i < timers.size(); i++) {
+            const GpuTimerStats& timer = timers[i];
+            out << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << escape(timer.name) << "\", \"last_ms\": " << timer.last
+                << ", \"min_ms\": " << timer.minimum << ", \"avg_ms\": " << timer.average << ", \"max_ms\": " << timer.maximum
+                << ", \"samples\": " << timer.samples << "}";
+        }
+        out << "\n  ]\n}\n";
+        return (bool)out;
+    }
+
+    // deletes the queries; the profiler outlives main(), so this runs while there's still a context
+    void destroy() {
+        for (std::vector<Pending>& pending : m_Pending) {
+            for (const Pending& timed : pending)
+                m_FreeQueries.push_back(timed.query);
+            pending.clear();
+        }
+        if (!m_FreeQueries.empty())
+            glDeleteQueries((GLsizei)m_FreeQueries.size(), &m_FreeQueries[0]);
+        m_FreeQueries.clear();
+    }
+
+private:
+    struct Timer {
+        std::string name;
+        float history[HISTORY];
+        unsigned int count = 0, next = 0;
+        float last = 0.0f;
+
+        void add(float milliseconds) {
+            last = milliseconds;
+            history[next] = milliseconds;
+            next = (next + 1) % HISTORY;
+            count = std::min(count + 1, (unsigned int)HISTORY);
+        }
+
+        GpuTimerStats stats() const {
+            GpuTimerStats result = GpuTimerStats{name, last, 0.0f, 0.0f, 0.0f, count};
+            if (count == 0)
+                return result;
+            result.minimum = result.maximum = history[0];
+            float total = 0.0f;
+            for (unsigned int i = 0; i < count; i++) {
+                result.minimum = std::min(result.minimum, history[i]);
+                result.maximum = std::max(result.maximum, history[i]);
+                total += history[i];
+            }
+            result.average = total / count;
+            return result;
+        }
+    };
+
+    struct Pending {
+        unsigned int timer;
+        GLuint query;
+    };
+
+    unsigned int timer(const std::string& name) {
+        std::map<std::string, unsigned int>::const_iterator it = m_Index.find(name);
+        if (it != m_Index.end())
+            return it->second;
+        Timer timer;
+        timer.name = name;
+        m_Timers.push_back(timer);
+        return m_Index[name] = (unsigned int)m_Timers.size() - 1;
+    }
+
+    GLuint takeQuery() {
+        if (m_FreeQueries.empty()) {
+            GLuint query;
+            glGenQueries(1, &query);
+            return query;
+        }
+        GLuint query = m_FreeQueries.back();
+        m_FreeQueries.pop_back();
+        return query;
+    }
+
+    static std::string escape(const std::string& text) {
+        std::string escaped;
+        for (char c : text) {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    std::vector<Timer> m_Timers;
+    std::map<std::string, unsigned int> m_Index;
+    std::vector<Pending> m_Pending[LATENCY_FRAMES];
+    std::vector<GLuint> m_FreeQueries;
+    unsigned long m_Frame = 0;
+};
+
+#else
+
+// profiling compiled out: no queries, no results
+class GpuProfiler {
+public:
+    void beginFrame() {}
+    void begin(const std::string&) {}
+    void end() {}
+    float lastMilliseconds(const std::string&) const { return 0.0f; }
+    std::vector<GpuTimerStats> stats() const { return std::vector<GpuTimerStats>(); }
+    bool writeCsv(const std::string&) const { return false; }
+    bool writeJson(const std::string&) const { return false; }
+    void destroy() {}
+};
+
+#endif
+
+// the one profiler every pass reports to
+inline GpuProfiler& gpuProfiler() {
+    static GpuProfiler profiler;
+    return profiler;
+}
+
+}
+#endif //PROJECT_BASE_GPUPROFILER_H
@@ -0,0 +1,128 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_HEADLESS_H
+#define PROJECT_BASE_HEADLESS_H
+
+#include <string>
+#ifdef RG_HEADLESS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+namespace rg {
+
+// OpenGL 3.3 core context without a window or a display server, for build and benchmark
+// machines. Goes through EGL: Mesa's surfaceless platform when it's there (works with
+// llvmpipe on machines without a GPU), the default display otherwise. The context is made
+// current without a surface where EGL_KHR_surfaceless_context allows it, else with a 1x1
+// pbuffer; either way there is no usable default framebuffer, everything is drawn into FBOs.
+// Needs the EGL library at build time (RG_HEADLESS_EGL, set by CMake when it finds it).
+class HeadlessContext {
+public:
+    HeadlessContext() = default;
+    HeadlessContext(const HeadlessContext&) = delete;
+    HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+#ifdef RG_HEADLESS_EGL
+    ~HeadlessContext() {
+        if (m_Display == EGL_NO_DISPLAY)
+            return;
+        eglMakeCurrent(m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (m_Context != EGL_NO_CONTEXT)
+            eglDestroyContext(m_Display, m_Context);
+        if (m_Surface != EGL_NO_SURFACE)
+            eglDestroySurface(m_Display, m_Surface);
+        eglTerminate(m_Display);
+    }
+
+    // makes the context current; false with a message in error when it can't
+    bool create(std::string& error) {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+                (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+        if (getPlatformDisplay != nullptr)
+            m_Display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+#endif
+        EGLint major, minor;
+        if (m_Display == EGL_NO_DISPLAY || !eglInitialize(m_Display, &major, &minor)) {
+            m_Display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+            if (m_Display == EGL_NO_DISPLAY || !eglInitialize(m_Display, &major, &minor)) {
+                m_Display = EGL_NO_DISPLAY;
+                error = "no EGL display";
+                return false;
+            }
+        }
+
+        const EGLint pbufferConfig[] = {
+                EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+                EGL_DEPTH_SIZE, 24,
+                EGL_NONE
+        };
+        // the surfaceless platform has no pbuffer configs
+        const EGLint anyConfig[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+        EGLConfig config;
+        EGLint configCount = 0;
+        if (!eglChooseConfig(m_Display, pbufferConfig, &config, 1, &configCount) || configCount == 0) {
+            if (!eglChooseConfig(m_Display, anyConfig, &config, 1, &configCount) || configCount == 0) {
+                error = "no EGL config with desktop OpenGL";
+                return false;
+            }
+        }
+
+        if (!eglBindAPI(EGL_OPENGL_API)) {
+            error = "EGL can't bind desktop OpenGL";
+            return false;
+        }
+        const EGLint contextAttributes[] = {
+                EGL_CONTEXT_MAJOR_VERSION_KHR, 3,
+                EGL_CONTEXT_MINOR_VERSION_KHR, 3,
+                EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+#ifdef RG_GL_DEBUG
+                EGL_CONTEXT_FLAGS_KHR, EGL_CONTEXT_OPENGL_DEBUG_BIT_KHR,
+#endif
+                EGL_NONE
+        };
+        m_Context = eglCreateContext(m_Display, config, EGL_NO_CONTEXT, contextAttributes);
+        if (m_Context == EGL_NO_CONTEXT) {
+            error = "can't create an OpenGL 3.3 core context through EGL";
+            return false;
+        }
+
+        if (!eglMakeCurrent(m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, m_Context)) {
+            const EGLint pbufferAttributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+            m_Surface = eglCreatePbufferSurface(m_Display, config, pbufferAttributes);
+            if (m_Surface == EGL_NO_SURFACE || !eglMakeCurrent(m_Display, m_Surface, m_Surface, m_Context)) {
+                error = "can't make the EGL context current";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // for gladLoadGLLoader
+    static void* getProcAddress(const char* name) {
+        return (void*)eglGetProcAddress(name);
+    }
+
+private:
+    EGLDisplay m_Display = EGL_NO_DISPLAY;
+    EGLContext m_Context = EGL_NO_CONTEXT;
+    EGLSurface m_Surface = EGL_NO_SURFACE;
+#else
+    bool create(std::string& error) {
+        error = "built without EGL, headless mode isn't available";
+        return false;
+    }
+
+    static void* getProcAddress(const char*) {
+        return nullptr;
+    }
+#endif
+};
+
+}
+#endif //PROJECT_BASE_HEADLESS_H
@@ -0,0 +1,341 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_LIGHTCLUSTERS_H
+#define PROJECT_BASE_LIGHTCLUSTERS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <learnopengl/shader.h>
+#include <rg/GLDebug.h>
+#include <rg/GLState.h>
+#include <rg/GpuMemory.h>
+#include <rg/PointLights.h>
+#include <rg/Trace.h>
+#include <rg/UniformBlocks.h>
+#include <rg/WorkerPool.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+namespace rg {
+
+// Point lights binned into the froxels of the camera frustum: 16x9 screen tiles times 24 depth
+// slices spaced exponentially between the near and far plane, so every slice is about as deep
+// as it is wide. Built on the CPU every frame, no GL calls, so it can be benchmarked headless.
+//  1. per light: view-space center and the range of depth slices its sphere touches
+//  2. per depth slice, one slice per job: the screen tiles the light's bounding box covers
+//     within that slice; each job only writes the clusters of its own slice
+//  3. the per-cluster lists are packed into one index list with an (offset, count) per cluster
+class LightGrid {
+public:
+    static const unsigned int TILES_X = 16;
+    static const unsigned int TILES_Y = 9;
+    static const unsigned int SLICES = 24;
+    static const unsigned int CLUSTER_COUNT = TILES_X * TILES_Y * SLICES;
+    // lights past this many in one cluster are dropped, counted in overflow()
+    static const unsigned int MAX_LIGHTS_PER_CLUSTER = 128;
+    // light indices are stored as 16 bit
+    static const unsigned int MAX_LIGHTS = 65535;
+
+    LightGrid() : m_Ranges(CLUSTER_COUNT), m_Lists(CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER), m_Counts(CLUSTER_COUNT) {}
+
+    // projection must be a symmetric perspective projection with the given near and far plane
+    void build(const std::vector<PointLightInstance>& lights, const glm::mat4& view, const glm::mat4& projection,
+               float zNear, float zFar, WorkerPool& pool) {
+        RG_TRACE_ZONE("LightGrid::build");
+        auto start = std::chrono::steady_clock::now();
+        m_LightCount = (unsigned int)std::min(lights.size(), (size_t)MAX_LIGHTS);
+        m_SliceScale = SLICES / std::log(zFar / zNear);
+        m_SliceBias = -std::log(zNear) * m_SliceScale;
+        for (unsigned int z = 0; z <= SLICES; z++)
+            m_SliceDepth[z] = zNear * std::pow(zFar / zNear, (float)z / SLICES);
+
+        m_Bounds.resize(m_LightCount);
+        const unsigned int chunk = 64;
+        pool.parallelFor((m_LightCount + chunk - 1) / chunk, [&](unsigned int job) {
+            unsigned int end = std::min(m_LightCount, (job + 1) * chunk);
+            for (unsigned int i = job * chunk; i < end; i++)
+                m_Bounds[i] = bound(lights[i], view, zNear, zFar);
+        });
+
+        const float scaleX = projection[0][0], scaleY = projection[1][1];
+        pool.parallelFor(SLICES, [&](unsigned int z) {
+            unsigned int* counts = &m_Counts[z * TILES_X * TILES_Y];
+            std::fill(counts, counts + TILES_X * TILES_Y, 0u);
+            unsigned int overflow = 0;
+            for (unsigned int i = 0; i < m_LightCount; i++) {
+                const LightBounds& light = m_Bounds[i];
+                if ((int)z < light.firstSlice || (int)z > light.lastSlice)
+                    continue;
+                float nearDepth = std::max(light.depth - light.radius, m_SliceDepth[z]);
+                float farDepth = std::min(light.depth + light.radius, m_SliceDepth[z + 1]);
+                unsigned int x0, x1, y0, y1;
+                if (!tileRange(light.center.x, light.radius, nearDepth, farDepth, scaleX, TILES_X, x0, x1)
+                    || !tileRange(light.center.y, light.radius, nearDepth, farDepth, scaleY, TILES_Y, y0, y1))
+                    continue;
+                for (unsigned int y = y0; y <= y1; y++) {
+                    for (unsigned int x = x0; x <= x1; x++) {
+                        unsigned int tile = y * TILES_X + x;
+                        if (counts[tile] == MAX_LIGHTS_PER_CLUSTER) {
+                            overflow++;
+                            continue;
+                        }
+                        unsigned int cluster = z * TILES_X * TILES_Y + tile;
+                        m_Lists[cluster * MAX_LIGHTS_PER_CLUSTER + counts[tile]++] = (unsigned short)i;
+                    }
+                }
+            }
+            m_SliceOverflow[z] = overflow;
+        });
+
+        unsigned int offset = 0;
+        m_MaxClusterLights = 0;
+        m_Overflow = 0;
+        for (unsigned int cluster = 0; cluster < CLUSTER_COUNT; cluster++) {
+            m_Ranges[cluster] = glm::uvec2(offset, m_Counts[cluster]);
+            offset += m_Counts[cluster];
+            m_MaxClusterLights = std::max(m_MaxClusterLights, m_Counts[cluster]);
+        }
+        for (unsigned int z = 0; z < SLICES; z++)
+            m_Overflow += m_SliceOverflow[z];
+        m_Indices.resize(std::max(offset, 1u));
+        pool.parallelFor(SLICES, [&](unsigned int z) {
+            for (unsigned int cluster = z * TILES_X * TILES_Y; cluster < (z + 1) * TILES_X * TILES_Y; cluster++) {
+                const unsigned short* list = &m_Lists[cluster * MAX_LIGHTS_PER_CLUSTER];
+                std::copy(list, list + m_Ranges[cluster].y, m_Indices.begin() + m_Ranges[cluster].x);
+            }
+        });
+        m_IndexCount = offset;
+        m_BuildMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // (offset into indices(), light count) per cluster, x fastest, then y, then depth slice
+    const std::vector<glm::uvec2>& ranges() const {
+        return m_Ranges;
+    }
+
+    // light indices of all clusters back to back, never empty so it can always be uploaded
+    const std::vector<unsigned short>& indices() const {
+        return m_Indices;
+    }
+
+    unsigned int indexCount() const {
+        return m_IndexCount;
+    }
+
+    unsigned int lightCount() const {
+        return m_LightCount;
+    }
+
+    unsigned int maxClusterLights() const {
+        return m_MaxClusterLights;
+    }
+
+    unsigned int overflow() const {
+        return m_Overflow;
+    }
+
+    // slice = log(view depth) * sliceScale + sliceBias
+    float sliceScale() const {
+        return m_SliceScale;
+    }
+
+    float sliceBias() const {
+        return m_SliceBias;
+    }
+
+    // how long the last build() took
+    float buildMilliseconds() const {
+        return m_BuildMilliseconds;
+    }
+
+private:
+    struct LightBounds {
+        glm::vec3 center;   // view space
+        float depth;        // distance in front of the camera
+        float radius;
+        int firstSlice, lastSlice;  // lastSlice < firstSlice when the light is outside the depth range
+    };
+
+    LightBounds bound(const PointLightInstance& light, const glm::mat4& view, float zNear, float zFar) const {
+        LightBounds bounds;
+        bounds.center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+        bounds.depth = -bounds.center.z;
+        bounds.radius = light.radius;
+        bounds.firstSlice = 0;
+        bounds.lastSlice = -1;
+        if (bounds.depth + light.radius < zNear || bounds.depth - light.radius > zFar)
+            return bounds;
+        bounds.firstSlice = slice(std::max(bounds.depth - light.radius, zNear));
+        bounds.lastSlice = slice(std::min(bounds.depth + light.radius, zFar));
+        return bounds;
+    }
+
+    int slice(float depth) const {
+        int z = (int)std::floor(std::log(depth) * m_SliceScale + m_SliceBias);
+        return std::min(std::max(z, 0), (int)SLICES - 1);
+    }
+
+    // Tiles along one screen axis covered by [center - radius, center + radius] for view depths
+    // in [nearDepth, farDepth]: each edge projects widest at whichever end of the depth range
+    // pulls it further from the axis. False when the range misses the screen.
+    static bool tileRange(float center, float radius, float nearDepth, float farDepth, float scale,
+                          unsigned int tiles, unsigned int& first, unsigned int& last) {
+        float high = center + radius, low = center - radius;
+        float ndcHigh = scale * high / (high > 0.0f ? nearDepth : farDepth);
+        float ndcLow = scale * low / (low < 0.0f ? nearDepth : farDepth);
+        if (ndcHigh < -1.0f || ndcLow > 1.0f)
+            return false;
+        first = toTile(ndcLow, tiles);
+        last = toTile(ndcHigh, tiles);
+        return true;
+    }
+
+    static unsigned int toTile(float ndc, unsigned int tiles) {
+        int tile = (int)std::floor((ndc * 0.5f + 0.5f) * tiles);
+        return (unsigned int)std::min(std::max(tile, 0), (int)tiles - 1);
+    }
+
+    std::vector<LightBounds> m_Bounds;
+    std::vector<glm::uvec2> m_Ranges;
+    std::vector<unsigned short> m_Lists;    // MAX_LIGHTS_PER_CLUSTER slots per cluster
+    std::vector<unsigned int> m_Counts;
+    std::vector<unsigned short> m_Indices = std::vector<unsigned short>(1);
+    float m_SliceDepth[SLICES + 1];
+    unsigned int m_SliceOverflow[SLICES];
+    float m_SliceScale = 0.0f, m_SliceBias = 0.0f;
+    unsigned int m_LightCount = 0;
+    unsigned int m_IndexCount = 0;
+    unsigned int m_MaxClusterLights = 0;
+    unsigned int m_Overflow = 0;
+    float m_BuildMilliseconds = 0.0f;
+};
+
+// The light grid on the GPU for the forward shaders, three buffer textures (texel fetches from
+// a plain buffer, core since 3.1) on consecutive units starting at firstUnit:
+//   clusterRanges  RG32UI   offset and count per cluster
+//   clusterIndices R16UI    light indices of every cluster
+//   clusterLights  RGBA32F  two texels per light: position + radius, color
+// plus the ClusterData uniform block. Every buffer is orphaned before it is rewritten.
+class LightClusters {
+public:
+    explicit LightClusters(unsigned int firstUnit) : m_FirstUnit(firstUnit), m_Data(CLUSTER_DATA_BINDING) {
+        create(m_Ranges, GL_RG32UI, "light cluster ranges");
+        create(m_Indices, GL_R16UI, "light cluster indices");
+        create(m_Lights, GL_RGBA32F, "light cluster lights");
+        glState().invalidate();
+    }
+
+    LightClusters(const LightClusters&) = delete;
+    LightClusters& operator=(const LightClusters&) = delete;
+
+    // points the cluster samplers of a forward shader at their units
+    void bindSamplers(Shader& shader) const {
+        shader.use();
+        shader.setInt("clusterRanges", (int)m_FirstUnit);
+        shader.setInt("clusterIndices", (int)m_FirstUnit + 1);
+        shader.setInt("clusterLights", (int)m_FirstUnit + 2);
+    }
+
+    // Bins the lights into grid for a frame's camera on this object's worker threads. No GL
+    // calls, so it can run on the update thread while the render thread submits with another
+    // grid; not reentrant, one thread builds at a time.
+    void build(LightGrid& grid, const std::vector<PointLightInstance>& lights, const glm::mat4& view,
+               const glm::mat4& projection, float zNear, float zFar) {
+        grid.build(lights, view, projection, zNear, zFar, m_Pool);
+    }
+
+    // Uploads a grid built from these lights, then binds the buffer textures. An empty grid
+    // after an empty one (the forward path, or no lanterns) leaves the buffers alone: every
+    // cluster is empty whatever the size, so there's nothing new to orphan and write.
+    void upload(const LightGrid& grid, const std::vector<PointLightInstance>& lights, unsigned int width,
+                unsigned int height) {
+        m_Uploaded = &grid;
+        if (grid.lightCount() == 0 && m_UploadedEmpty) {
+            bind();
+            return;
+        }
+        m_UploadedEmpty = grid.lightCount() == 0;
+        m_LightTexels.resize(2 * std::max(grid.lightCount(), 1u));
+        for (unsigned int i = 0; i < grid.lightCount(); i++) {
+            m_LightTexels[2 * i] = glm::vec4(lights[i].position, lights[i].radius);
+            m_LightTexels[2 * i + 1] = glm::vec4(lights[i].color, 0.0f);
+        }
+        upload(m_Ranges, grid.ranges().size() * sizeof(glm::uvec2), &grid.ranges()[0]);
+        upload(m_Indices, grid.indices().size() * sizeof(unsigned short), &grid.indices()[0]);
+        upload(m_Lights, m_LightTexels.size() * sizeof(glm::vec4), &m_LightTexels[0]);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+        ClusterData data;
+        data.grid = glm::vec4((float)LightGrid::TILES_X, (float)LightGrid::TILES_Y, (float)LightGrid::SLICES, (float)grid.lightCount());
+        data.params = glm::vec4((float)width, (float)height, grid.sliceScale(), grid.sliceBias());
+        m_Data.update(data);
+        bind();
+    }
+
+    // the grid of the last upload(), only valid as long as that grid is
+    const LightGrid& grid() const {
+        return *m_Uploaded;
+    }
+
+    float buildMilliseconds() const {
+        return m_Uploaded->buildMilliseconds();
+    }
+
+    unsigned int workerThreads() const {
+        return m_Pool.size();
+    }
+
+private:
+    struct TextureBuffer {
+        GLuint buffer = 0;
+        GLuint texture = 0;
+        GLsizeiptr capacity = 0;
+    };
+
+    static void create(TextureBuffer& target, GLenum format, const char* name) {
+        glGenBuffers(1, &target.buffer);
+        glGenTextures(1, &target.texture);
+        glBindBuffer(GL_TEXTURE_BUFFER, target.buffer);
+        glBufferData(GL_TEXTURE_BUFFER, 16, NULL, GL_STREAM_DRAW);
+        target.capacity = 16;
+        gpuMemory().trackBuffer(target.buffer, 16, RG_GPU_MEMORY_SITE, "light clusters");
+        glBindTexture(GL_TEXTURE_BUFFER, target.texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, format, target.buffer);
+        RG_GL_LABEL(GL_BUFFER, target.buffer, name);
+        RG_GL_LABEL(GL_TEXTURE, target.texture, name);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    void bind() const {
+        GLState& state = glState();
+        state.bindTexture(m_FirstUnit, GL_TEXTURE_BUFFER, m_Ranges.texture);
+        state.bindTexture(m_FirstUnit + 1, GL_TEXTURE_BUFFER, m_Indices.texture);
+        state.bindTexture(m_FirstUnit + 2, GL_TEXTURE_BUFFER, m_Lights.texture);
+    }
+
+    static void upload(TextureBuffer& target, GLsizeiptr size, const void* data) {
+        glBindBuffer(GL_TEXTURE_BUFFER, target.buffer);
+        // grows to the largest size seen, the texture keeps pointing at the same buffer object
+        if (size > target.capacity)
+            gpuMemory().trackBuffer(target.buffer, size, RG_GPU_MEMORY_SITE, "light clusters");
+        target.capacity = std::max(target.capacity, size);
+        glBufferData(GL_TEXTURE_BUFFER, target.capacity, NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+    }
+
+    unsigned int m_FirstUnit;
+    WorkerPool m_Pool;
+    const LightGrid* m_Uploaded = nullptr;
+    bool m_UploadedEmpty = false;
+    std::vector<glm::vec4> m_LightTexels;
+    TextureBuffer m_Ranges, m_Indices, m_Lights;
+    UniformBuffer<ClusterData> m_Data;
+};
+
+}
+#endif //PROJECT_BASE_LIGHTCLUSTERS_H
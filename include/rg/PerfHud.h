@@ -0,0 +1,169 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_PERFHUD_H
+#define PROJECT_BASE_PERFHUD_H
+
+#include "imgui.h"
+#include <glad/glad.h>
+#include <rg/FramePacing.h>
+#include <rg/FrameStats.h>
+#include <rg/GLDebug.h>
+#include <rg/GLState.h>
+#include <rg/GLStats.h>
+#include <rg/GpuMemory.h>
+#include <rg/RenderGraph.h>
+#include <rg/RenderTargetPool.h>
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace rg {
+
+// what the HUD shows for one frame
+struct HudSample {
+    float frameMilliseconds;    // from the start of this frame to the start of the next
+    float cpuMilliseconds;      // from the start of the frame until the render graph ran, the HUD isn't in it
+    float gpuMilliseconds;      // latest GPU time of the graph's passes
+    DrawCounters draws;
+    GLState::Counters state;
+    unsigned int visibleObjects;
+    unsigned int culledObjects;
+    PacingMode pacing;
+    float targetFps;            // of the capped mode
+    float latencyMilliseconds;  // input latch to the GPU finishing the frame (LatencyMeter)
+    float latencyAverage;
+    float latencyMaximum;
+    bool pipelined;             // the update ran a frame ahead on its own thread (FramePipeline)
+    float updateMilliseconds;
+    float updateWaitMilliseconds;   // the render thread waiting for the update
+};
+
+// Performance overlay: a rolling graph of frame times plus the latest CPU and GPU time per
+// render pass, draw calls, triangles, state changes, memory, frustum culling and what each
+// model cost. Samples go into fixed arrays every frame whether it's shown or not, so turning
+// it on changes neither the allocations nor the work of the frames it measures; it is drawn
+// with the rest of ImGui after the frame's passes were timed.
+class PerfHud {
+public:
+    static const unsigned int HISTORY = 240;
+
+    bool visible = false;
+
+    // a model whose lastFrameCost gets a row; call while setting up, not per frame
+    void addModel(const std::string& name, const DrawCost* cost) {
+        m_Models.push_back(ModelRow{name, cost});
+    }
+
+    void record(const HudSample& sample) {
+        m_Last = sample;
+        m_FrameTimes[m_Next] = sample.frameMilliseconds;
+        m_CpuTimes[m_Next] = sample.cpuMilliseconds;
+        m_Next = (m_Next + 1) % HISTORY;
+        m_Count = std::min(m_Count + 1, HISTORY);
+    }
+
+    void draw(const RenderGraph& graph, const RenderTargetPool& targets) const {
+        if (!visible)
+            return;
+        ImGui::SetNextWindowPos(ImVec2(10.0f, 10.0f), ImGuiCond_FirstUseEver);
+        ImGui::SetNextWindowBgAlpha(0.6f);
+        ImGui::Begin("Performance", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+
+        float worst = 0.0f, total = 0.0f;
+        for (unsigned int i = 0; i < m_Count; i++) {
+            worst = std::max(worst, m_FrameTimes[i]);
+            total += m_FrameTimes[i];
+        }
+        float average = m_Count > 0 ? total / m_Count : 0.0f;
+        char overlay[64];
+        std::snprintf(overlay, sizeof(overlay), "%.2f ms avg, %.2f max", average, worst);
+        // oldest sample first; the scale keeps a little headroom above the worst frame
+        ImGui::PlotLines("Frame", m_FrameTimes, (int)m_Count, m_Count < HISTORY ? 0 : (int)m_Next, overlay,
+                         0.0f, std::max(worst * 1.2f, 1.0f), ImVec2(300.0f, 60.0f));
+        ImGui::PlotLines("CPU", m_CpuTimes, (int)m_Count, m_Count < HISTORY ? 0 : (int)m_Next, nullptr,
+                         0.0f, std::max(worst * 1.2f, 1.0f), ImVec2(300.0f, 40.0f));
+        ImGui::Text("Frame %.2f ms (%.0f fps), CPU %.2f ms, GPU %.2f ms", m_Last.frameMilliseconds,
+                    m_Last.frameMilliseconds > 0.0f ? 1000.0f / m_Last.frameMilliseconds : 0.0f,
+                    m_Last.cpuMilliseconds, m_Last.gpuMilliseconds);
+        ImGui::Text("Update %.2f ms %s, waited for %.2f ms", m_Last.updateMilliseconds,
+                    m_Last.pipelined ? "on its own thread" : "on the render thread", m_Last.updateWaitMilliseconds);
+
+        if (m_Last.pacing == PACING_CAPPED)
+            ImGui::Text("Pacing %s at %.0f fps", pacingModeName(m_Last.pacing), m_Last.targetFps);
+        else
+            ImGui::Text("Pacing %s", pacingModeName(m_Last.pacing));
+        ImGui::Text("Input latency %.2f ms (average %.2f, max %.2f), plus scan-out", m_Last.latencyMilliseconds,
+                    m_Last.latencyAverage, m_Last.latencyMaximum);
+
+        ImGui::Separator();
+        ImGui::Text("%-20s %8s %8s", "Pass", "CPU ms", "GPU ms");
+        for (const RenderGraph::PassStats& pass : graph.stats()) {
+            if (pass.culled)
+                ImGui::TextDisabled("%-20s %8s", pass.name.c_str(), "culled");
+            else
+                ImGui::Text("%-20s %8.3f %8.3f", pass.name.c_str(), pass.cpuMilliseconds, pass.gpuMilliseconds);
+        }
+
+        ImGui::Separator();
+        ImGui::Text("Draw calls %lu, triangles %lu", m_Last.draws.drawCalls, m_Last.draws.triangles);
+        ImGui::Text("State changes %lu (%lu skipped by the cache)", m_Last.state.issued, m_Last.state.skipped);
+#ifdef RG_GL_STATS
+        GLStats::Frame calls = glStats().lastFrame();
+        ImGui::Text("GL calls %lu (%lu draws, %lu binds), %.1f KB uploaded", calls.calls, calls.draws, calls.binds,
+                    calls.uploadBytes / 1024.0);
+#endif
+        ImGui::Text("Objects %u visible, %u culled", m_Last.visibleObjects, m_Last.culledObjects);
+        const double megabyte = 1024.0 * 1024.0;
+        const GpuMemory& memory = gpuMemory();
+        ImGui::Text("GPU memory %.1f MB: textures %.1f MB (render targets %.1f MB), buffers %.1f MB", memory.total() / megabyte,
+                    memory.total(GpuMemory::TEXTURE) / megabyte, targets.bytes() / megabyte,
+                    memory.total(GpuMemory::BUFFER) / megabyte);
+        if (memory.budget() > 0) {
+            ImGui::ProgressBar((float)((double)memory.total() / memory.budget()), ImVec2(300.0f, 0.0f));
+            ImGui::SameLine();
+            ImGui::Text("of %.0f MB%s", memory.budget() / megabyte, memory.overBudget() ? ", over budget" : "");
+        }
+        if (memory.droppedMipLevels() > 0)
+            ImGui::Text("%u top mip levels dropped to stay in budget", memory.droppedMipLevels());
+        if (ImGui::CollapsingHeader("GPU memory by asset")) {
+            for (const auto& owner : memory.byOwner())
+                ImGui::Text("%-28s %8.2f MB", owner.first.c_str(), owner.second / megabyte);
+        }
+
+#ifdef RG_GL_DEBUG
+        // the driver's performance log, as far as it tells us
+        const unsigned long warnings = glDebug().performanceWarningCount();
+        if (warnings > 0 && ImGui::CollapsingHeader("Driver performance warnings")) {
+            ImGui::Text("%lu so far, the latest:", warnings);
+            for (const std::string& warning : glDebug().performanceWarnings())
+                ImGui::TextWrapped("%s", warning.c_str());
+        }
+#endif
+        if (!m_Models.empty() && ImGui::CollapsingHeader("Models")) {
+            ImGui::Text("%-28s %6s %9s %7s", "Model", "draws", "triangles", "CPU ms");
+            for (const ModelRow& model : m_Models) {
+                ImGui::Text("%-28s %6lu %9lu %7.3f", model.name.c_str(), model.cost->drawCalls, model.cost->triangles,
+                            model.cost->cpuMilliseconds);
+            }
+        }
+        ImGui::End();
+    }
+
+private:
+    struct ModelRow {
+        std::string name;
+        const DrawCost* cost;
+    };
+
+    float m_FrameTimes[HISTORY] = {};
+    float m_CpuTimes[HISTORY] = {};
+    unsigned int m_Next = 0, m_Count = 0;
+    HudSample m_Last = HudSample();
+    std::vector<ModelRow> m_Models;
+};
+
+}
+#endif //PROJECT_BASE_PERFHUD_H
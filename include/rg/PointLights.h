@@ -0,0 +1,21 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_POINTLIGHTS_H
+#define PROJECT_BASE_POINTLIGHTS_H
+
+#include <glm/glm.hpp>
+
+namespace rg {
+
+// one of the many small point lights, shared by the deferred light volumes (as per-instance
+// vertex data) and the clustered forward path (as texels of a buffer texture)
+struct PointLightInstance {
+    glm::vec3 position;
+    float radius;       // the light fades to exactly zero here
+    glm::vec3 color;
+};
+
+}
+#endif //PROJECT_BASE_POINTLIGHTS_H
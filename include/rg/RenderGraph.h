@@ -0,0 +1,361 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_RENDERGRAPH_H
+#define PROJECT_BASE_RENDERGRAPH_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <rg/GLDebug.h>
+#include <rg/GLState.h>
+#include <rg/GpuProfiler.h>
+#include <rg/RenderTargetPool.h>
+#include <rg/Trace.h>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace rg {
+
+// a texture of the graph, only meaningful during the frame it was created in
+struct RGTexture {
+    int index = -1;
+
+    bool valid() const {
+        return index >= 0;
+    }
+};
+
+// what happens to an attachment's previous contents when a pass starts drawing into it
+enum LoadOp {
+    LOAD_OP_LOAD = 0,       // keep them, the pass draws on top
+    LOAD_OP_CLEAR,          // clear to the attachment's clear value
+    LOAD_OP_DONT_CARE       // the pass covers every pixel, no clear needed
+};
+
+// The frame as a list of passes that declare the textures they read and write. Every frame
+// the passes are added again, then execute():
+//  - culls passes none of whose writes are read later (walking back from the passes with
+//    side effects and the imported textures, which outlive the frame); a cleared attachment
+//    doesn't keep the passes before it alive
+//  - acquires each transient texture from the pool right before its first kept pass and
+//    releases it after its last one, so textures whose lifetimes don't overlap are shared
+//  - binds the framebuffer and viewport of passes that have attachments, and clears only
+//    the attachments that ask for it, in one call per attachment
+//  - times each pass on the CPU and, as a scope of the GPU profiler, on the GPU
+// Passes run in the order they were added; nothing is reordered.
+class RenderGraph {
+public:
+    class Context;
+
+private:
+    struct Resource {
+        std::string name;
+        RenderTargetDesc desc;
+        bool imported = false;
+        GLuint texture = 0;
+        int firstUse = -1, lastUse = -1;
+    };
+
+    struct Attachment {
+        int resource;
+        LoadOp load;
+        glm::vec4 clearValue;
+    };
+
+    struct Pass {
+        std::string name;
+        std::function<void(Context&)> execute;
+        std::vector<int> reads, writes;
+        Attachment colors[RenderTargetPool::MAX_COLORS];
+        unsigned int colorCount = 0;
+        Attachment depth = Attachment{-1, LOAD_OP_LOAD, glm::vec4(1.0f)};
+        bool sideEffect = false;
+        bool culled = false;
+#ifdef RG_TRACE
+        const char* traceName = nullptr;    // the tracer's copy of name, see traceName()
+#endif
+    };
+
+public:
+    struct PassStats {
+        std::string name;
+        bool culled;
+        float cpuMilliseconds;
+        float gpuMilliseconds;  // latest result that came back, 0 until then or without RG_GPU_PROFILER
+    };
+
+    // handed to a pass while it runs
+    class Context {
+    public:
+        GLuint texture(RGTexture handle) const {
+            return m_Graph->m_Resources[handle.index].texture;
+        }
+
+        // framebuffer bound for the pass's attachments, 0 when it has none (or draws to the screen)
+        GLuint framebuffer() const {
+            return m_Framebuffer;
+        }
+
+    private:
+        friend class RenderGraph;
+        const RenderGraph* m_Graph = nullptr;
+        GLuint m_Framebuffer = 0;
+    };
+
+    // declares what a pass touches, returned by addPass
+    class PassBuilder {
+    public:
+        // sampled, blitted from or otherwise read
+        PassBuilder& read(RGTexture texture) {
+            if (texture.valid())
+                pass().reads.push_back(texture.index);
+            return *this;
+        }
+
+        // written through framebuffers the pass binds itself
+        PassBuilder& write(RGTexture texture) {
+            if (texture.valid())
+                pass().writes.push_back(texture.index);
+            return *this;
+        }
+
+        // drawn into as the next color attachment of the pass's framebuffer
+        PassBuilder& color(RGTexture texture, LoadOp load, const glm::vec4& clearValue = glm::vec4(0.0f)) {
+            Pass& target = pass();
+            if (texture.valid() && target.colorCount < RenderTargetPool::MAX_COLORS) {
+                target.colors[target.colorCount++] = Attachment{texture.index, load, clearValue};
+                target.writes.push_back(texture.index);
+            }
+            return *this;
+        }
+
+        PassBuilder& depth(RGTexture texture, LoadOp load) {
+            if (texture.valid()) {
+                pass().depth = Attachment{texture.index, load, glm::vec4(1.0f)};
+                pass().writes.push_back(texture.index);
+            }
+            return *this;
+        }
+
+        // never culled, e.g. it updates state outside the graph
+        PassBuilder& sideEffect() {
+            pass().sideEffect = true;
+            return *this;
+        }
+
+    private:
+        friend class RenderGraph;
+        PassBuilder(RenderGraph& graph, unsigned int index) : m_Graph(graph), m_Index(index) {}
+
+        Pass& pass() {
+            return m_Graph.m_Passes[m_Index];
+        }
+
+        RenderGraph& m_Graph;
+        unsigned int m_Index;
+    };
+
+    explicit RenderGraph(RenderTargetPool& pool) : m_Pool(pool) {}
+
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+
+    // transient texture, allocated from the pool only if a pass that uses it survives culling
+    RGTexture create(const std::string& name, const RenderTargetDesc& desc) {
+        Resource resource;
+        resource.name = name;
+        resource.desc = desc;
+        m_Resources.push_back(resource);
+        return handle(m_Resources.size() - 1);
+    }
+
+    // texture owned outside the graph; 0 stands for the default framebuffer
+    RGTexture import(const std::string& name, GLuint texture, unsigned int width, unsigned int height) {
+        Resource resource;
+        resource.name = name;
+        resource.desc = RenderTargetDesc{width, height, GL_NONE, GL_NONE};
+        resource.imported = true;
+        resource.texture = texture;
+        m_Resources.push_back(resource);
+        return handle(m_Resources.size() - 1);
+    }
+
+    PassBuilder addPass(const std::string& name, std::function<void(Context&)> execute) {
+        Pass pass;
+        pass.name = name;
+#ifdef RG_TRACE
+        pass.traceName = traceName(name);
+#endif
+        pass.execute = std::move(execute);
+        m_Passes.push_back(std::move(pass));
+        return PassBuilder(*this, (unsigned int)m_Passes.size() - 1);
+    }
+
+    // runs the frame's passes and forgets them
+    void execute() {
+        RG_TRACE_ZONE("RenderGraph::execute");
+        cull();
+        computeLifetimes();
+
+        GLState& state = glState();
+        GpuProfiler& profiler = gpuProfiler();
+        Context context;
+        context.m_Graph = this;
+        m_Stats.clear();
+        for (unsigned int i = 0; i < m_Passes.size(); i++) {
+            Pass& pass = m_Passes[i];
+            PassStats stats = PassStats{pass.name, pass.culled, 0.0f, profiler.lastMilliseconds(pass.name)};
+            if (pass.culled) {
+                m_Stats.push_back(stats);
+                continue;
+            }
+            for (unsigned int r = 0; r < m_Resources.size(); r++) {
+                Resource& resource = m_Resources[r];
+                if (!resource.imported && resource.firstUse == (int)i) {
+                    resource.texture = m_Pool.acquire(resource.desc);
+                    // a pooled texture is a different resource from frame to frame
+                    RG_GL_LABEL(GL_TEXTURE, resource.texture, resource.name);
+                }
+            }
+
+            RG_TRACE_ZONE(pass.traceName);
+            RG_GL_DEBUG_GROUP(pass.name);
+            auto start = std::chrono::steady_clock::now();
+            profiler.begin(pass.name);
+            context.m_Framebuffer = bindAttachments(pass, state);
+            RG_GL_LABEL(GL_FRAMEBUFFER, context.m_Framebuffer, pass.name);
+            pass.execute(context);
+            profiler.end();
+            stats.cpuMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+            m_Stats.push_back(stats);
+
+            for (unsigned int r = 0; r < m_Resources.size(); r++) {
+                Resource& resource = m_Resources[r];
+                if (!resource.imported && resource.lastUse == (int)i)
+                    m_Pool.release(resource.texture);
+            }
+        }
+        m_Passes.clear();
+        m_Resources.clear();
+    }
+
+    // passes of the last executed frame in order, culled ones included
+    const std::vector<PassStats>& stats() const {
+        return m_Stats;
+    }
+
+    // latest GPU time of the passes that ran in the last executed frame, 0 until results come back
+    float gpuMilliseconds() const {
+        float total = 0.0f;
+        for (const PassStats& pass : m_Stats) {
+            if (!pass.culled)
+                total += pass.gpuMilliseconds;
+        }
+        return total;
+    }
+
+private:
+#ifdef RG_TRACE
+    // interned once per pass name, so the zone of a pass takes no lock frame after frame
+    const char* traceName(const std::string& name) {
+        std::map<std::string, const char*>::const_iterator it = m_TraceNames.find(name);
+        if (it == m_TraceNames.end())
+            it = m_TraceNames.insert(std::make_pair(name, tracer().intern(name))).first;
+        return it->second;
+    }
+#endif
+
+    static RGTexture handle(size_t index) {
+        RGTexture texture;
+        texture.index = (int)index;
+        return texture;
+    }
+
+    void cull() {
+        std::vector<bool> needed(m_Resources.size(), false);
+        for (unsigned int r = 0; r < m_Resources.size(); r++)
+            needed[r] = m_Resources[r].imported;
+        for (int i = (int)m_Passes.size() - 1; i >= 0; i--) {
+            Pass& pass = m_Passes[i];
+            bool keep = pass.sideEffect;
+            for (int resource : pass.writes)
+                keep = keep || needed[resource];
+            pass.culled = !keep;
+            if (!keep)
+                continue;
+            // whatever was in an overwritten attachment before this pass is never seen
+            for (unsigned int c = 0; c < pass.colorCount; c++)
+                overwrite(pass.colors[c], needed);
+            if (pass.depth.resource >= 0)
+                overwrite(pass.depth, needed);
+            for (int resource : pass.reads)
+                needed[resource] = true;
+        }
+    }
+
+    void overwrite(const Attachment& attachment, std::vector<bool>& needed) const {
+        if (attachment.load != LOAD_OP_LOAD && !m_Resources[attachment.resource].imported)
+            needed[attachment.resource] = false;
+    }
+
+    void computeLifetimes() {
+        for (unsigned int i = 0; i < m_Passes.size(); i++) {
+            const Pass& pass = m_Passes[i];
+            if (pass.culled)
+                continue;
+            for (const std::vector<int>* list : {&pass.reads, &pass.writes}) {
+                for (int r : *list) {
+                    Resource& resource = m_Resources[r];
+                    if (resource.firstUse < 0)
+                        resource.firstUse = (int)i;
+                    resource.lastUse = (int)i;
+                }
+            }
+        }
+    }
+
+    GLuint bindAttachments(const Pass& pass, GLState& state) {
+        if (pass.colorCount == 0 && pass.depth.resource < 0)
+            return 0;
+        const Resource& first = m_Resources[pass.colorCount > 0 ? pass.colors[0].resource : pass.depth.resource];
+        GLuint fbo = 0;
+        // the default framebuffer is only ever drawn to on its own
+        if (!(first.imported && first.texture == 0)) {
+            GLuint colors[RenderTargetPool::MAX_COLORS];
+            for (unsigned int c = 0; c < pass.colorCount; c++)
+                colors[c] = m_Resources[pass.colors[c].resource].texture;
+            GLuint depth = pass.depth.resource >= 0 ? m_Resources[pass.depth.resource].texture : 0;
+            fbo = m_Pool.framebuffer(colors, pass.colorCount, depth);
+        }
+        state.bindFramebuffer(fbo);
+        glViewport(0, 0, first.desc.width, first.desc.height);
+
+        for (unsigned int c = 0; c < pass.colorCount; c++) {
+            if (pass.colors[c].load != LOAD_OP_CLEAR)
+                continue;
+            state.colorMask(true);
+            glClearBufferfv(GL_COLOR, (GLint)c, &pass.colors[c].clearValue[0]);
+        }
+        if (pass.depth.resource >= 0 && pass.depth.load == LOAD_OP_CLEAR) {
+            state.depthMask(true);
+            GLfloat one = 1.0f;
+            glClearBufferfv(GL_DEPTH, 0, &one);
+        }
+        return fbo;
+    }
+
+    RenderTargetPool& m_Pool;
+    std::vector<Resource> m_Resources;
+    std::vector<Pass> m_Passes;
+    std::vector<PassStats> m_Stats;
+#ifdef RG_TRACE
+    std::map<std::string, const char*> m_TraceNames;
+#endif
+};
+
+}
+#endif //PROJECT_BASE_RENDERGRAPH_H
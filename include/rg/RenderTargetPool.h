@@ -0,0 +1,244 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_RENDERTARGETPOOL_H
+#define PROJECT_BASE_RENDERTARGETPOOL_H
+
+#include <glad/glad.h>
+#include <rg/GLState.h>
+#include <rg/GpuMemory.h>
+#include <cstddef>
+#include <initializer_list>
+#include <iostream>
+#include <vector>
+
+namespace rg {
+
+// what a render target is: size, sized internal format and how it is sampled
+struct RenderTargetDesc {
+    unsigned int width;
+    unsigned int height;
+    GLenum format;          // GL_R11F_G11F_B10F, GL_RG16F, GL_RGBA8, GL_R8, GL_DEPTH_COMPONENT24, ...
+    GLenum filter;          // GL_LINEAR or GL_NEAREST, edges always clamp
+
+    bool operator==(const RenderTargetDesc& other) const {
+        return width == other.width && height == other.height && format == other.format && filter == other.filter;
+    }
+};
+
+// Every render target of the frame comes from here, nobody owns a texture across frames.
+// acquire() returns a free texture with the same description or creates one; release()
+// hands it back so a later pass of the same frame can reuse it (its contents are then
+// lost), which lets targets whose lifetimes don't overlap share memory. endFrame() hands
+// back whatever is still held and deletes targets nobody asked for in the last few frames,
+// so after a window resize the old sizes go away on their own and the new ones are created
+// lazily the first time they're needed. Framebuffers are cached per set of attachments.
+class RenderTargetPool {
+public:
+    static const unsigned int EVICT_AFTER_FRAMES = 3;
+    static const unsigned int MAX_COLORS = 4;
+
+    RenderTargetPool() = default;
+    RenderTargetPool(const RenderTargetPool&) = delete;
+    RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+    ~RenderTargetPool() {
+        for (const Framebuffer& framebuffer : m_Framebuffers)
+            glDeleteFramebuffers(1, &framebuffer.fbo);
+        for (const Target& target : m_Targets) {
+            glDeleteTextures(1, &target.texture);
+            gpuMemory().release(GpuMemory::TEXTURE, target.texture);
+        }
+    }
+
+    GLuint acquire(const RenderTargetDesc& desc) {
+        for (Target& target : m_Targets) {
+            if (target.inUse || !(target.desc == desc))
+                continue;
+            // handed out before in this same frame, so this is a texture shared by two targets
+            if (target.lastUsed == m_Frame)
+                ++m_Aliased;
+            target.inUse = true;
+            target.lastUsed = m_Frame;
+            return target.texture;
+        }
+        Target target;
+        target.desc = desc;
+        target.texture = create(desc);
+        target.inUse = true;
+        target.lastUsed = m_Frame;
+        m_Targets.push_back(target);
+        return target.texture;
+    }
+
+    void release(GLuint texture) {
+        for (Target& target : m_Targets) {
+            if (target.texture == texture) {
+                target.inUse = false;
+                return;
+            }
+        }
+    }
+
+    // framebuffer with up to MAX_COLORS color attachments (drawn in order) and an optional depth
+    GLuint framebuffer(std::initializer_list<GLuint> colors, GLuint depth = 0) {
+        return framebuffer(colors.begin(), (unsigned int)colors.size(), depth);
+    }
+
+    GLuint framebuffer(const GLuint* colors, unsigned int colorCount, GLuint depth) {
+        Framebuffer key;
+        for (unsigned int i = 0; i < colorCount && i < MAX_COLORS; i++)
+            key.colors[key.colorCount++] = colors[i];
+        key.depth = depth;
+        for (const Framebuffer& framebuffer : m_Framebuffers) {
+            if (framebuffer.sameAttachments(key))
+                return framebuffer.fbo;
+        }
+        glGenFramebuffers(1, &key.fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, key.fbo);
+        GLenum drawBuffers[MAX_COLORS];
+        for (unsigned int i = 0; i < key.colorCount; i++) {
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, key.colors[i], 0);
+            drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+        }
+        if (depth != 0)
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth, 0);
+        if (key.colorCount > 0) {
+            glDrawBuffers(key.colorCount, drawBuffers);
+        } else {
+            glDrawBuffer(GL_NONE);
+            glReadBuffer(GL_NONE);
+        }
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "Pooled framebuffer not complete!" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glState().invalidate();
+        m_Framebuffers.push_back(key);
+        return key.fbo;
+    }
+
+    void endFrame() {
+        std::vector<Target> kept;
+        for (Target& target : m_Targets) {
+            target.inUse = false;
+            if (m_Frame - target.lastUsed < EVICT_AFTER_FRAMES)
+                kept.push_back(target);
+            else
+                destroy(target.texture);
+        }
+        m_Targets.swap(kept);
+        m_LastAliased = m_Aliased;
+        m_Aliased = 0;
+        ++m_Frame;
+    }
+
+    // GPU memory of every pooled target, in use or not
+    size_t bytes() const {
+        size_t total = 0;
+        for (const Target& target : m_Targets)
+            total += (size_t)target.desc.width * target.desc.height * bytesPerPixel(target.desc.format);
+        return total;
+    }
+
+    unsigned int targetCount() const {
+        return (unsigned int)m_Targets.size();
+    }
+
+    // acquires of the last frame served by a texture another target had already used that frame
+    unsigned int aliasedLastFrame() const {
+        return m_LastAliased;
+    }
+
+private:
+    struct Target {
+        RenderTargetDesc desc;
+        GLuint texture;
+        bool inUse;
+        unsigned long lastUsed;
+    };
+
+    struct Framebuffer {
+        GLuint fbo = 0;
+        GLuint colors[MAX_COLORS] = {};
+        unsigned int colorCount = 0;
+        GLuint depth = 0;
+
+        bool sameAttachments(const Framebuffer& other) const {
+            if (colorCount != other.colorCount || depth != other.depth)
+                return false;
+            for (unsigned int i = 0; i < colorCount; i++) {
+                if (colors[i] != other.colors[i])
+                    return false;
+            }
+            return true;
+        }
+
+        bool references(GLuint texture) const {
+            for (unsigned int i = 0; i < colorCount; i++) {
+                if (colors[i] == texture)
+                    return true;
+            }
+            return depth == texture;
+        }
+    };
+
+    // pixel transfer format and type glTexImage2D accepts together with the internal format
+    static void transferFormat(GLenum internalFormat, GLenum& format, GLenum& type) {
+        switch (internalFormat) {
+            case GL_DEPTH_COMPONENT24: format = GL_DEPTH_COMPONENT; type = GL_UNSIGNED_INT; return;
+            case GL_DEPTH_COMPONENT32F: format = GL_DEPTH_COMPONENT; type = GL_FLOAT; return;
+            case GL_DEPTH24_STENCIL8: format = GL_DEPTH_STENCIL; type = GL_UNSIGNED_INT_24_8; return;
+            case GL_R8: format = GL_RED; type = GL_UNSIGNED_BYTE; return;
+            case GL_RGBA8: format = GL_RGBA; type = GL_UNSIGNED_BYTE; return;
+            case GL_R16F:
+            case GL_R32F: format = GL_RED; type = GL_FLOAT; return;
+            case GL_RG16F: format = GL_RG; type = GL_FLOAT; return;
+            case GL_R11F_G11F_B10F:
+            case GL_RGB16F: format = GL_RGB; type = GL_FLOAT; return;
+        }
+        format = GL_RGBA;
+        type = GL_FLOAT;
+    }
+
+    static GLuint create(const RenderTargetDesc& desc) {
+        GLenum format, type;
+        transferFormat(desc.format, format, type);
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, desc.format, desc.width, desc.height, 0, format, type, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, desc.filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, desc.filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glState().invalidate();
+        gpuMemory().trackTexture(texture, desc.width, desc.height, desc.format, false, RG_GPU_MEMORY_SITE,
+                                 "render targets");
+        return texture;
+    }
+
+    // deletes the texture along with every cached framebuffer it is attached to
+    void destroy(GLuint texture) {
+        std::vector<Framebuffer> kept;
+        for (const Framebuffer& framebuffer : m_Framebuffers) {
+            if (framebuffer.references(texture))
+                glDeleteFramebuffers(1, &framebuffer.fbo);
+            else
+                kept.push_back(framebuffer);
+        }
+        m_Framebuffers.swap(kept);
+        glDeleteTextures(1, &texture);
+        gpuMemory().release(GpuMemory::TEXTURE, texture);
+        glState().invalidate();
+    }
+
+    std::vector<Target> m_Targets;
+    std::vector<Framebuffer> m_Framebuffers;
+    unsigned long m_Frame = 0;
+    unsigned int m_Aliased = 0;
+    unsigned int m_LastAliased = 0;
+};
+
+}
+#endif //PROJECT_BASE_RENDERTARGETPOOL_H
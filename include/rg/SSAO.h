@@ -0,0 +1,158 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_SSAO_H
+#define PROJECT_BASE_SSAO_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <learnopengl/shader.h>
+#include <rg/GLState.h>
+#include <rg/RenderTargetPool.h>
+#include <rg/UniformBlocks.h>
+#include <random>
+#include <vector>
+
+namespace rg {
+
+// Screen-space ambient occlusion computed from the scene depth buffer alone. View-space
+// positions are reconstructed from depth and normals from their screen derivatives, so
+// no position or normal buffer is needed. Occlusion runs at half resolution and stores
+// the linear depth next to it; a depth-aware 4x4 filter then blurs and upsamples it to
+// full resolution in one pass without bleeding across silhouettes. The sample kernel
+// lives in the SSAOKernel uniform block and is only uploaded when sampleCount changes.
+// The half resolution target comes from the render target pool and is handed back as
+// soon as the upsample has read it.
+class SSAO {
+public:
+    unsigned int sampleCount = 16;  // at most MAX_SSAO_SAMPLES
+    float radius = 0.5f;            // hemisphere radius in view space units
+    float bias = 0.025f;
+    float power = 1.0f;             // contrast of the result
+    float depthSharpness = 20.0f;   // how fast upsample weights fall off with relative depth difference
+
+    explicit SSAO(RenderTargetPool& pool)
+        : m_Pool(pool),
+          m_Occlusion("resources/shaders/ssao.vs", "resources/shaders/ssao.fs"),
+          m_Upsample("resources/shaders/ssao.vs", "resources/shaders/ssao_upsample.fs"),
+          m_Kernel(SSAO_KERNEL_BINDING) {
+        m_Occlusion.use();
+        m_Occlusion.setInt("depthMap", 0);
+        m_Occlusion.setInt("texNoise", 1);
+        m_InverseProjectionLoc = m_Occlusion.uniform("inverseProjection");
+        m_NoiseScaleLoc = m_Occlusion.uniform("noiseScale");
+        m_SampleCountLoc = m_Occlusion.uniform("sampleCount");
+        m_RadiusLoc = m_Occlusion.uniform("radius");
+        m_BiasLoc = m_Occlusion.uniform("bias");
+        m_PowerLoc = m_Occlusion.uniform("power");
+        m_Upsample.use();
+        m_Upsample.setInt("aoInput", 0);
+        m_Upsample.setInt("depthMap", 1);
+        m_SharpnessLoc = m_Upsample.uniform("depthSharpness");
+
+        createNoise();
+    }
+
+    SSAO(const SSAO&) = delete;
+    SSAO& operator=(const SSAO&) = delete;
+
+    // computes occlusion for the width x height depth buffer of the scene into target, a full
+    // resolution single channel texture (1 = unoccluded, see targetDesc); projection must be
+    // the one depth was drawn with. Leaves the viewport at the full width x height.
+    void render(GLuint depthTexture, GLuint target, unsigned int width, unsigned int height, const glm::mat4& projection, void (*drawQuad)()) {
+        GLState& state = glState();
+        updateKernel();
+
+        // r: occlusion, g: linear view depth of the texel the occlusion was computed for;
+        // nearest: the upsample weighs individual half resolution texels by their depth
+        GLuint half = m_Pool.acquire(RenderTargetDesc{width / 2, height / 2, GL_RG16F, GL_NEAREST});
+
+        state.bindFramebuffer(m_Pool.framebuffer({half}));
+        glViewport(0, 0, width / 2, height / 2);
+        m_Occlusion.use();
+        m_Occlusion.setMat4(m_InverseProjectionLoc, glm::inverse(projection));
+        m_Occlusion.setVec2(m_NoiseScaleLoc, glm::vec2((width / 2) / 4.0f, (height / 2) / 4.0f));
+        m_Occlusion.setInt(m_SampleCountLoc, (int)m_KernelSize);
+        m_Occlusion.setFloat(m_RadiusLoc, radius);
+        m_Occlusion.setFloat(m_BiasLoc, bias);
+        m_Occlusion.setFloat(m_PowerLoc, power);
+        state.bindTexture(0, GL_TEXTURE_2D, depthTexture);
+        state.bindTexture(1, GL_TEXTURE_2D, m_NoiseTexture);
+        drawQuad();
+
+        state.bindFramebuffer(m_Pool.framebuffer({target}));
+        glViewport(0, 0, width, height);
+        m_Upsample.use();
+        m_Upsample.setFloat(m_SharpnessLoc, depthSharpness);
+        state.bindTexture(0, GL_TEXTURE_2D, half);
+        state.bindTexture(1, GL_TEXTURE_2D, depthTexture);
+        drawQuad();
+
+        m_Pool.release(half);
+    }
+
+    static RenderTargetDesc targetDesc(unsigned int width, unsigned int height) {
+        return RenderTargetDesc{width, height, GL_R8, GL_NEAREST};
+    }
+
+private:
+    static float lerp(float a, float b, float f) {
+        return a + f * (b - a);
+    }
+
+    void updateKernel() {
+        unsigned int count = sampleCount;
+        if (count < 1)
+            count = 1;
+        if (count > MAX_SSAO_SAMPLES)
+            count = MAX_SSAO_SAMPLES;
+        if (count == m_KernelSize)
+            return;
+        m_KernelSize = count;
+
+        std::uniform_real_distribution<GLfloat> randomFloats(0.0, 1.0);
+        std::default_random_engine generator;
+        SSAOKernel kernel = SSAOKernel();
+        for (unsigned int i = 0; i < count; ++i) {
+            glm::vec3 sample(randomFloats(generator) * 2.0 - 1.0, randomFloats(generator) * 2.0 - 1.0, randomFloats(generator));
+            sample = glm::normalize(sample);
+            sample *= randomFloats(generator);
+            // scale samples s.t. they're more aligned to center of kernel
+            float scale = float(i) / float(count);
+            sample *= lerp(0.1f, 1.0f, scale * scale);
+            kernel.samples[i] = glm::vec4(sample, 0.0f);
+        }
+        m_Kernel.update(kernel);
+    }
+
+    void createNoise() {
+        std::uniform_real_distribution<GLfloat> randomFloats(0.0, 1.0);
+        std::default_random_engine generator(7);
+        std::vector<glm::vec3> noise;
+        for (unsigned int i = 0; i < 16; i++) {
+            // rotate around z-axis (in tangent space)
+            noise.push_back(glm::vec3(randomFloats(generator) * 2.0 - 1.0, randomFloats(generator) * 2.0 - 1.0, 0.0f));
+        }
+        glGenTextures(1, &m_NoiseTexture);
+        glBindTexture(GL_TEXTURE_2D, m_NoiseTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, 4, 4, 0, GL_RGB, GL_FLOAT, &noise[0]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glState().invalidate();
+    }
+
+    RenderTargetPool& m_Pool;
+    Shader m_Occlusion;
+    Shader m_Upsample;
+    UniformBuffer<SSAOKernel> m_Kernel;
+    unsigned int m_KernelSize = 0;
+    int m_InverseProjectionLoc, m_NoiseScaleLoc, m_SampleCountLoc, m_RadiusLoc, m_BiasLoc, m_PowerLoc;
+    int m_SharpnessLoc;
+    GLuint m_NoiseTexture = 0;
+};
+
+}
+#endif //PROJECT_BASE_SSAO_H
@@ -0,0 +1,55 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_SSAOEFFECT_H
+#define PROJECT_BASE_SSAOEFFECT_H
+
+#include "imgui.h"
+#include <rg/Effects.h>
+#include <rg/SSAO.h>
+
+namespace rg {
+
+// ambient occlusion from the scene depth, see SSAO; the shading passes multiply it in
+class SSAOEffect : public Effect {
+public:
+    explicit SSAOEffect(RenderTargetPool& pool) : m_SSAO(pool) {}
+
+    const char* name() const override {
+        return "SSAO";
+    }
+
+    EffectStage stage() const override {
+        return EFFECT_STAGE_DEPTH;
+    }
+
+    void addPasses(RenderGraph& graph, FrameResources& frame) override {
+        RGTexture depth = frame.sceneDepth;
+        RGTexture occlusion = graph.create("ambient occlusion", SSAO::targetDesc(frame.width, frame.height));
+        unsigned int width = frame.width, height = frame.height;
+        glm::mat4 projection = frame.projection;
+        void (*drawQuad)() = frame.drawQuad;
+        graph.addPass("SSAO", [this, depth, occlusion, width, height, projection, drawQuad](RenderGraph::Context& context) {
+            m_SSAO.render(context.texture(depth), context.texture(occlusion), width, height, projection, drawQuad);
+        }).read(depth).write(occlusion);
+        frame.ambientOcclusion = occlusion;
+    }
+
+    void drawSettings() override {
+        int samples = m_SSAO.sampleCount;
+        if (ImGui::SliderInt("Samples", &samples, 4, MAX_SSAO_SAMPLES))
+            m_SSAO.sampleCount = samples;
+        ImGui::DragFloat("Radius", &m_SSAO.radius, 0.01, 0.05, 4.0);
+        ImGui::DragFloat("Bias", &m_SSAO.bias, 0.001, 0.0, 0.2);
+        ImGui::DragFloat("Power", &m_SSAO.power, 0.05, 0.25, 4.0);
+    }
+
+private:
+    SSAO m_SSAO;
+};
+
+static EffectRegistration<SSAOEffect> ssaoEffectRegistration;
+
+}
+#endif //PROJECT_BASE_SSAOEFFECT_H
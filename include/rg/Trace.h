@@ -0,0 +1,213 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_TRACE_H
+#define PROJECT_BASE_TRACE_H
+
+// CPU zones for a Chrome trace_event JSON file that chrome://tracing and Perfetto open.
+// RG_TRACE_ZONE("name") times the rest of the enclosing block; the name must outlive the
+// program (a string literal), RG_TRACE_ZONE_DYNAMIC takes any std::string and keeps a
+// copy. RG_TRACE_THREAD_NAME labels the calling thread in the trace. Everything compiles
+// to nothing unless RG_TRACE is defined (the RG_TRACE CMake option).
+
+#ifdef RG_TRACE
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#if defined(__x86_64__) || defined(_M_X64)
+#include <x86intrin.h>
+#define RG_TRACE_TSC
+#endif
+
+namespace rg {
+
+// The zones of one thread, written only by that thread. The last CAPACITY zones are kept;
+// the write index is published with a release store, so dumping from another thread sees
+// every zone up to it without locking the writer. A zone the writer is overwriting while
+// the dump reads it can come out garbled; dump when the frame is done to avoid that.
+class TraceBuffer {
+public:
+    static const unsigned int CAPACITY = 1u << 15;
+
+    struct Zone {
+        const char* name;
+        uint64_t start, end;
+    };
+
+    TraceBuffer(unsigned int id, std::string name) : m_Id(id), m_Name(std::move(name)), m_Zones(CAPACITY) {}
+
+    void record(const char* name, uint64_t start, uint64_t end) {
+        uint64_t index = m_Written.load(std::memory_order_relaxed);
+        m_Zones[index & (CAPACITY - 1)] = Zone{name, start, end};
+        m_Written.store(index + 1, std::memory_order_release);
+    }
+
+    unsigned int id() const {
+        return m_Id;
+    }
+
+    const std::string& name() const {
+        return m_Name;
+    }
+
+    void setName(const std::string& name) {
+        m_Name = name;
+    }
+
+    // the zones still in the ring, oldest first
+    template<typename F>
+    void forEach(F&& visit) const {
+        uint64_t written = m_Written.load(std::memory_order_acquire);
+        uint64_t first = written > CAPACITY ? written - CAPACITY : 0;
+        for (uint64_t i = first; i < written; i++)
+            visit(m_Zones[i & (CAPACITY - 1)]);
+    }
+
+private:
+    unsigned int m_Id;
+    std::string m_Name;
+    std::vector<Zone> m_Zones;
+    std::atomic<uint64_t> m_Written{0};
+};
+
+class Tracer {
+public:
+    // raw timestamp: the time stamp counter on x86-64, steady_clock nanoseconds elsewhere
+    static uint64_t now() {
+#ifdef RG_TRACE_TSC
+        return __rdtsc();
+#else
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    Tracer() : m_OriginTicks(now()), m_OriginTime(std::chrono::steady_clock::now()) {}
+
+    // buffer of the calling thread, created the first time the thread records a zone;
+    // buffers live as long as the tracer, so zones of finished threads still get dumped
+    TraceBuffer& thisThread() {
+        static thread_local TraceBuffer* buffer = nullptr;
+        if (buffer == nullptr) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            unsigned int id = (unsigned int)m_Buffers.size() + 1;
+            m_Buffers.push_back(std::unique_ptr<TraceBuffer>(new TraceBuffer(id, "thread " + std::to_string(id))));
+            buffer = m_Buffers.back().get();
+        }
+        return *buffer;
+    }
+
+    void setThreadName(const std::string& name) {
+        TraceBuffer& buffer = thisThread();
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        buffer.setName(name);
+    }
+
+    // stable copy of a name that isn't a literal
+    const char* intern(const std::string& name) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Names.insert(name).first->c_str();
+    }
+
+    bool writeChromeJson(const std::string& path) {
+        std::ofstream out(path);
+        if (!out)
+            return false;
+        double microsecondsPerTick = calibrate();
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        out << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+        bool first = true;
+        for (const std::unique_ptr<TraceBuffer>& buffer : m_Buffers) {
+            out << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->id()
+                << ", \"args\": {\"name\": \"" << escape(buffer->name()) << "\"}}";
+            first = false;
+            buffer->forEach([&](const TraceBuffer::Zone& zone) {
+                if (zone.start < m_OriginTicks || zone.end < zone.start)
+                    return;
+                out << ",\n{\"name\": \"" << escape(zone.name) << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer->id()
+                    << ", \"ts\": " << (zone.start - m_OriginTicks) * microsecondsPerTick
+                    << ", \"dur\": " << (zone.end - zone.start) * microsecondsPerTick << "}";
+            });
+        }
+        out << "\n]}\n";
+        return (bool)out;
+    }
+
+private:
+    // microseconds per tick of now(), measured against steady_clock since the tracer started
+    double calibrate() const {
+#ifdef RG_TRACE_TSC
+        uint64_t ticks = now() - m_OriginTicks;
+        double microseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - m_OriginTime).count();
+        return ticks > 0 ? microseconds / ticks : 0.0;
+#else
+        return 1.0e-3;
+#endif
+    }
+
+    static std::string escape(const std::string& text) {
+        std::string escaped;
+        for (char c : text) {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    uint64_t m_OriginTicks;
+    std::chrono::steady_clock::time_point m_OriginTime;
+    std::mutex m_Mutex;
+    std::vector<std::unique_ptr<TraceBuffer>> m_Buffers;
+    std::set<std::string> m_Names;
+};
+
+inline Tracer& tracer() {
+    static Tracer instance;
+    return instance;
+}
+
+class TraceZone {
+public:
+    explicit TraceZone(const char* name) : m_Name(name), m_Start(Tracer::now()) {}
+
+    ~TraceZone() {
+        tracer().thisThread().record(m_Name, m_Start, Tracer::now());
+    }
+
+    TraceZone(const TraceZone&) = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+
+private:
+    const char* m_Name;
+    uint64_t m_Start;
+};
+
+}
+
+#define RG_TRACE_CONCAT_(a, b) a##b
+#define RG_TRACE_CONCAT(a, b) RG_TRACE_CONCAT_(a, b)
+#define RG_TRACE_ZONE(name) rg::TraceZone RG_TRACE_CONCAT(rgTraceZone, __LINE__)(name)
+#define RG_TRACE_ZONE_DYNAMIC(name) rg::TraceZone RG_TRACE_CONCAT(rgTraceZone, __LINE__)(rg::tracer().intern(name))
+#define RG_TRACE_THREAD_NAME(name) rg::tracer().setThreadName(name)
+#define RG_TRACE_WRITE(path) rg::tracer().writeChromeJson(path)
+
+#else
+
+#define RG_TRACE_ZONE(name) do {} while (0)
+#define RG_TRACE_ZONE_DYNAMIC(name) do {} while (0)
+#define RG_TRACE_THREAD_NAME(name) do {} while (0)
+#define RG_TRACE_WRITE(path) do {} while (0)
+
+#endif
+
+#endif //PROJECT_BASE_TRACE_H
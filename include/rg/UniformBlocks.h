@@ -0,0 +1,154 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_UNIFORMBLOCKS_H
+#define PROJECT_BASE_UNIFORMBLOCKS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <rg/GpuMemory.h>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace rg {
+
+// fixed binding points of the shared uniform blocks, every program gets its blocks
+// attached to these right after linking (see Shader::bindUniformBlocks)
+enum UniformBlockBinding {
+    FRAME_DATA_BINDING = 0,
+    LIGHT_DATA_BINDING = 1,
+    SSAO_KERNEL_BINDING = 2,
+    CLUSTER_DATA_BINDING = 3,
+};
+
+inline int uniformBlockBinding(const std::string& blockName) {
+    if (blockName == "FrameData")
+        return FRAME_DATA_BINDING;
+    if (blockName == "LightData")
+        return LIGHT_DATA_BINDING;
+    if (blockName == "SSAOKernel")
+        return SSAO_KERNEL_BINDING;
+    if (blockName == "ClusterData")
+        return CLUSTER_DATA_BINDING;
+    return -1;
+}
+
+// The structs below mirror the std140 blocks declared in resources/shaders byte for byte.
+// A vec3 is followed by a float wherever std140 would leave that slot as padding.
+
+// layout (std140) uniform FrameData
+struct FrameData {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec3 cameraPosition;
+    float time;
+    float deltaTime;
+    float padding[3];
+};
+
+struct DirLightStd140 {
+    glm::vec3 direction;
+    float padding0;
+    glm::vec3 ambient;
+    float padding1;
+    glm::vec3 diffuse;
+    float padding2;
+    glm::vec3 specular;
+    float padding3;
+};
+
+struct PointLightStd140 {
+    glm::vec3 position;
+    float constant;
+    glm::vec3 ambient;
+    float linear;
+    glm::vec3 diffuse;
+    float quadratic;
+    glm::vec3 specular;
+    float padding;
+};
+
+struct BloomLightStd140 {
+    glm::vec3 position;
+    float padding0;
+    glm::vec3 color;
+    float padding1;
+};
+
+const unsigned int MAX_BLOOM_LIGHTS = 4;
+
+// layout (std140) uniform LightData
+struct LightData {
+    DirLightStd140 dirLight;
+    PointLightStd140 pointLight;
+    BloomLightStd140 lights[MAX_BLOOM_LIGHTS];
+};
+
+const unsigned int MAX_SSAO_SAMPLES = 64;
+
+// layout (std140) uniform SSAOKernel, hemisphere samples in tangent space (w unused)
+struct SSAOKernel {
+    glm::vec4 samples[MAX_SSAO_SAMPLES];
+};
+
+// layout (std140) uniform ClusterData, how a fragment finds its cluster of the light grid
+struct ClusterData {
+    glm::vec4 grid;     // tiles across, tiles up, depth slices, lights in the grid
+    glm::vec4 params;   // viewport width, viewport height, depth slice scale, depth slice bias
+};
+
+static_assert(sizeof(FrameData) == 160, "FrameData must match the std140 FrameData block");
+static_assert(offsetof(FrameData, cameraPosition) == 128, "FrameData must match the std140 FrameData block");
+static_assert(sizeof(DirLightStd140) == 64, "DirLight must match its std140 layout");
+static_assert(sizeof(PointLightStd140) == 64, "PointLight must match its std140 layout");
+static_assert(sizeof(LightData) == 256, "LightData must match the std140 LightData block");
+static_assert(sizeof(SSAOKernel) == 16 * MAX_SSAO_SAMPLES, "SSAOKernel must match the std140 SSAOKernel block");
+static_assert(sizeof(ClusterData) == 32, "ClusterData must match the std140 ClusterData block");
+
+// One uniform buffer bound to a fixed binding point for the lifetime of the program.
+// update() writes the whole block with a single glBufferSubData and skips the write
+// when the contents did not change since the previous frame.
+template <typename Block>
+class UniformBuffer {
+public:
+    explicit UniformBuffer(unsigned int binding) : m_Binding(binding), m_Shadow() {
+        glGenBuffers(1, &m_Id);
+        glBindBuffer(GL_UNIFORM_BUFFER, m_Id);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), NULL, GL_DYNAMIC_DRAW);
+        gpuMemory().trackBuffer(m_Id, sizeof(Block), RG_GPU_MEMORY_SITE, "uniform blocks");
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, binding, m_Id);
+    }
+
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+    void update(const Block& data) {
+        if (m_Written && std::memcmp(&m_Shadow, &data, sizeof(Block)) == 0)
+            return;
+        std::memcpy(&m_Shadow, &data, sizeof(Block));
+        m_Written = true;
+        glBindBuffer(GL_UNIFORM_BUFFER, m_Id);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Block), &data);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    unsigned int id() const {
+        return m_Id;
+    }
+
+    unsigned int binding() const {
+        return m_Binding;
+    }
+
+private:
+    unsigned int m_Id = 0;
+    unsigned int m_Binding;
+    bool m_Written = false;
+    Block m_Shadow;
+};
+
+}
+#endif //PROJECT_BASE_UNIFORMBLOCKS_H
@@ -0,0 +1,122 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_WORKERPOOL_H
+#define PROJECT_BASE_WORKERPOOL_H
+
+#include <rg/Trace.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rg {
+
+// A few threads that stay alive for the whole run and sleep between jobs, so spreading a
+// small per-frame task over the cores doesn't pay for thread creation every frame.
+// parallelFor() hands out indices one at a time through an atomic counter; the calling
+// thread takes part as well and the call returns only when every index has been run.
+class WorkerPool {
+public:
+    // workers besides the calling thread, by default one per remaining hardware thread
+    explicit WorkerPool(unsigned int workers = defaultWorkers()) {
+        for (unsigned int i = 0; i < workers; i++)
+            m_Threads.emplace_back(&WorkerPool::workerLoop, this, i);
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stop = true;
+        }
+        m_Wake.notify_all();
+        for (std::thread& thread : m_Threads)
+            thread.join();
+    }
+
+    // threads that run a parallelFor, the caller included
+    unsigned int size() const {
+        return (unsigned int)m_Threads.size() + 1;
+    }
+
+    // calls job(i) for every i in [0, count), not reentrant
+    void parallelFor(unsigned int count, const std::function<void(unsigned int)>& job) {
+        if (m_Threads.empty() || count <= 1) {
+            for (unsigned int i = 0; i < count; i++)
+                job(i);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Job = &job;
+            m_Count = count;
+            m_Next = 0;
+            m_Busy = (unsigned int)m_Threads.size();
+            ++m_Generation;
+        }
+        m_Wake.notify_all();
+        run(job, count);
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Done.wait(lock, [this] { return m_Busy == 0; });
+        m_Job = nullptr;
+    }
+
+    static unsigned int defaultWorkers() {
+        unsigned int threads = std::thread::hardware_concurrency();
+        return threads > 1 ? threads - 1 : 0;
+    }
+
+private:
+    void run(const std::function<void(unsigned int)>& job, unsigned int count) {
+        RG_TRACE_ZONE("WorkerPool job");
+        for (;;) {
+            unsigned int i = m_Next.fetch_add(1);
+            if (i >= count)
+                return;
+            job(i);
+        }
+    }
+
+    void workerLoop(unsigned int index) {
+        RG_TRACE_THREAD_NAME("worker " + std::to_string(index + 1));
+        unsigned long seen = 0;
+        for (;;) {
+            const std::function<void(unsigned int)>* job;
+            unsigned int count;
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_Wake.wait(lock, [this, seen] { return m_Stop || m_Generation != seen; });
+                if (m_Stop)
+                    return;
+                seen = m_Generation;
+                job = m_Job;
+                count = m_Count;
+            }
+            run(*job, count);
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (--m_Busy == 0)
+                m_Done.notify_one();
+        }
+    }
+
+    std::vector<std::thread> m_Threads;
+    std::mutex m_Mutex;
+    std::condition_variable m_Wake;
+    std::condition_variable m_Done;
+    const std::function<void(unsigned int)>* m_Job = nullptr;
+    unsigned int m_Count = 0;
+    std::atomic<unsigned int> m_Next{0};
+    unsigned int m_Busy = 0;
+    unsigned long m_Generation = 0;
+    bool m_Stop = false;
+};
+
+}
+#endif //PROJECT_BASE_WORKERPOOL_H
@@ -1,27 +1,40 @@
 #version 330 core
 out vec4 FragColor;
 
+struct DirLight {
+    vec3 direction;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
 struct PointLight {
     vec3 position;
-    vec3 specular;
-    vec3 diffuse;
-    vec3 ambient;
     float constant;
+    vec3 ambient;
     float linear;
+    vec3 diffuse;
     float quadratic;
+    vec3 specular;
 };
 
-struct DirLight {
-    vec3 direction;
-    vec3 specular;
-    vec3 diffuse;
-    vec3 ambient;
+struct Light {
+    vec3 Position;
+    vec3 Color;
+};
+
+layout (std140) uniform LightData {
+    DirLight dirLight;
+    PointLight pointLight;
+    Light lights[4];
 };
 
 struct Material {
     sampler2D texture_diffuse1;
     sampler2D texture_specular1;
 
+    vec4 diffuseFactor;
+
     float shininess;
     float shininessBP;
 };
@@ -30,11 +43,39 @@ in vec2 TexCoords;
 in vec3 Normal;
 in vec3 FragPos;
 
-uniform PointLight pointLight;
 uniform Material material;
-uniform vec3 viewPosition;
 uniform bool blinn;
-uniform DirLight dirLight;
+// screen-sized ambient occlusion, white when SSAO is off
+uniform sampler2D ambientOcclusion;
+
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 cameraPosition;
+    float time;
+    float deltaTime;
+};
+
+// lanterns binned into froxels on the CPU (rg::LightClusters), only the lights of the
+// fragment's own cluster are visited
+layout (std140) uniform ClusterData {
+    vec4 clusterGrid;     // tiles across, tiles up, depth slices, lights in the grid
+    vec4 clusterParams;   // viewport width, viewport height, depth slice scale, depth slice bias
+};
+uniform usamplerBuffer clusterRanges;   // offset, count per cluster
+uniform usamplerBuffer clusterIndices;
+uniform samplerBuffer clusterLights;    // position + radius, color per light
+
+// the diffuse map scaled by the material's base color
+vec4 diffuseColor()
+{
+    return texture(material.texture_diffuse1, TexCoords) * material.diffuseFactor;
+}
+
+float ambientFactor()
+{
+    return texture(ambientOcclusion, gl_FragCoord.xy / vec2(textureSize(ambientOcclusion, 0))).r;
+}
 
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
 {
@@ -56,19 +97,22 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
 
     // ambient
-    vec3 ambient = light.ambient * vec3(texture(material.texture_diffuse1, TexCoords));
+    vec3 ambient = light.ambient * vec3(diffuseColor());
 
     // diffuse component
-    vec4 diffSample = texture(material.texture_diffuse1, TexCoords);
+    vec4 diffSample = diffuseColor();
+#ifdef ALPHA_TEST
+    // only compiled in for cutout meshes drawn without a depth pre-pass, discard disables early-Z
     if(diffSample.a < 0.4) {
         discard;
     }
+#endif
     vec3 diffuse = light.diffuse * diff * vec3(diffSample);
 
     // specular
     vec3 specular = light.specular * spec * vec3(texture(material.texture_specular1, TexCoords).xxx);
 
-    ambient *= attenuation;
+    ambient *= attenuation * ambientFactor();
     diffuse *= attenuation;
     specular *= attenuation;
 
@@ -77,11 +121,11 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
 
 vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir) {
     //ambient
-    vec3 ambient = light.ambient * texture(material.texture_diffuse1, TexCoords).rgb;
+    vec3 ambient = light.ambient * diffuseColor().rgb * ambientFactor();
     //diffuse
     vec3 lightDir = normalize(-light.direction);
     float diff = max(dot(lightDir, normal), 0.0);
-    vec3 diffuse = light.diffuse * diff * texture(material.texture_diffuse1, TexCoords).rgb;
+    vec3 diffuse = light.diffuse * diff * diffuseColor().rgb;
     //specular
     vec3 reflectDir = reflect(-lightDir, normal);
     float spec = 0.0f;
@@ -93,11 +137,48 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir) {
     return (ambient + diffuse + specular);
 }
 
+vec3 CalcClusterLights(vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    float depth = -(view * vec4(fragPos, 1.0)).z;
+    vec3 cell = vec3(gl_FragCoord.xy / clusterParams.xy * clusterGrid.xy, log(depth) * clusterParams.z + clusterParams.w);
+    ivec3 cluster = clamp(ivec3(cell), ivec3(0), ivec3(clusterGrid.xyz) - 1);
+    int index = (cluster.z * int(clusterGrid.y) + cluster.y) * int(clusterGrid.x) + cluster.x;
+    uvec2 range = texelFetch(clusterRanges, index).xy;
+    if (range.y == 0u)
+        return vec3(0.0);
+
+    vec3 albedo = diffuseColor().rgb;
+    float specularMask = texture(material.texture_specular1, TexCoords).r;
+    vec3 result = vec3(0.0);
+    for (uint i = 0u; i < range.y; i++) {
+        int light = int(texelFetch(clusterIndices, int(range.x + i)).r);
+        vec4 positionRadius = texelFetch(clusterLights, 2 * light);
+        vec3 toLight = positionRadius.xyz - fragPos;
+        float distance = length(toLight);
+        if (distance >= positionRadius.w)
+            continue;
+        // same falloff as the deferred light volumes
+        float window = clamp(1.0 - pow(distance / positionRadius.w, 4.0), 0.0, 1.0);
+        float attenuation = window * window / (distance * distance + 1.0);
+        vec3 lightDir = toLight / distance;
+        vec3 halfwayDir = normalize(lightDir + viewDir);
+        vec3 diffuse = max(dot(normal, lightDir), 0.0) * albedo;
+        vec3 specular = vec3(pow(max(dot(normal, halfwayDir), 0.0), material.shininessBP) * specularMask);
+        result += texelFetch(clusterLights, 2 * light + 1).rgb * (diffuse + specular) * attenuation;
+    }
+    return result;
+}
+
 void main()
 {
     vec3 normal = normalize(Normal);
-    vec3 viewDir = normalize(viewPosition - FragPos);
+    vec3 viewDir = normalize(cameraPosition - FragPos);
     vec3 result = CalcPointLight(pointLight, normal, FragPos, viewDir);
     result += CalcDirLight(dirLight, normal, viewDir);
+    result += CalcClusterLights(normal, FragPos, viewDir);
+#ifdef ALPHA_BLEND
+    FragColor = vec4(result, diffuseColor().a);
+#else
     FragColor = vec4(result, 1.0);
+#endif
 }
\ No newline at end of file
@@ -7,9 +7,19 @@ out vec2 TexCoords;
 out vec3 Normal;
 out vec3 FragPos;
 
+// the depth pre-pass computes gl_Position with the same expression, invariance keeps
+// both bit-identical so the main pass can run with GL_EQUAL
+invariant gl_Position;
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 cameraPosition;
+    float time;
+    float deltaTime;
+};
 
 void main()
 {
@@ -1,6 +1,5 @@
 #version 330 core
 layout (location = 0) out vec4 FragColor;
-layout (location = 1) out vec4 BrightColor;
 
 in VS_OUT {
     vec3 FragPos;
@@ -8,14 +7,43 @@ in VS_OUT {
     vec2 TexCoords;
 } fs_in;
 
+struct DirLight {
+    vec3 direction;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+struct PointLight {
+    vec3 position;
+    float constant;
+    vec3 ambient;
+    float linear;
+    vec3 diffuse;
+    float quadratic;
+    vec3 specular;
+};
+
 struct Light {
     vec3 Position;
     vec3 Color;
 };
 
-uniform Light lights[4];
+layout (std140) uniform LightData {
+    DirLight dirLight;
+    PointLight pointLight;
+    Light lights[4];
+};
+
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 cameraPosition;
+    float time;
+    float deltaTime;
+};
+
 uniform sampler2D diffuseTexture;
-uniform vec3 viewPos;
 
 void main()
 {
@@ -25,7 +53,7 @@ void main()
     vec3 ambient = 0.0 * color;
     // lighting
     vec3 lighting = vec3(0.0);
-    vec3 viewDir = normalize(viewPos - fs_in.FragPos);
+    vec3 viewDir = normalize(cameraPosition - fs_in.FragPos);
     for(int i = 0; i < 4; i++)
     {
         // diffuse
@@ -39,12 +67,6 @@ void main()
 
     }
     vec3 result = ambient + lighting;
-    // check whether result is higher than some threshold, if so, output as bloom threshold color
-    float brightness = dot(result, vec3(0.2126, 0.7152, 0.0722));
-    if(brightness > 1.0)
-        BrightColor = vec4(result, 1.0);
-    else
-        BrightColor = vec4(0.0, 0.0, 0.0, 1.0);
     FragColor = vec4(result, 1.0);
 }
 
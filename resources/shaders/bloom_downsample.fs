@@ -0,0 +1,49 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D source;
+uniform vec2 sourceTexelSize;
+// first level only: keep just the parts of the scene brighter than threshold
+uniform bool prefilter;
+uniform float threshold;
+uniform float knee;
+
+vec3 brightPass(vec3 color)
+{
+    float brightness = dot(color, vec3(0.2126, 0.7152, 0.0722));
+    // quadratic ramp of width 2 * knee around the threshold instead of a hard step
+    float soft = clamp(brightness - threshold + knee, 0.0, 2.0 * knee);
+    soft = soft * soft / (4.0 * knee + 0.00001);
+    float contribution = max(soft, brightness - threshold) / max(brightness, 0.00001);
+    return color * contribution;
+}
+
+void main()
+{
+    // 13 bilinear taps: a 4x4 box around the center plus four overlapping 2x2 boxes
+    vec2 t = sourceTexelSize;
+    vec3 a = texture(source, TexCoords + t * vec2(-2.0,  2.0)).rgb;
+    vec3 b = texture(source, TexCoords + t * vec2( 0.0,  2.0)).rgb;
+    vec3 c = texture(source, TexCoords + t * vec2( 2.0,  2.0)).rgb;
+    vec3 d = texture(source, TexCoords + t * vec2(-2.0,  0.0)).rgb;
+    vec3 e = texture(source, TexCoords).rgb;
+    vec3 f = texture(source, TexCoords + t * vec2( 2.0,  0.0)).rgb;
+    vec3 g = texture(source, TexCoords + t * vec2(-2.0, -2.0)).rgb;
+    vec3 h = texture(source, TexCoords + t * vec2( 0.0, -2.0)).rgb;
+    vec3 i = texture(source, TexCoords + t * vec2( 2.0, -2.0)).rgb;
+    vec3 j = texture(source, TexCoords + t * vec2(-1.0,  1.0)).rgb;
+    vec3 k = texture(source, TexCoords + t * vec2( 1.0,  1.0)).rgb;
+    vec3 l = texture(source, TexCoords + t * vec2(-1.0, -1.0)).rgb;
+    vec3 m = texture(source, TexCoords + t * vec2( 1.0, -1.0)).rgb;
+
+    vec3 result = e * 0.125;
+    result += (a + c + g + i) * 0.03125;
+    result += (b + d + f + h) * 0.0625;
+    result += (j + k + l + m) * 0.125;
+
+    if (prefilter)
+        result = brightPass(result);
+    FragColor = vec4(result, 1.0);
+}
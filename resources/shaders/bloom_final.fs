@@ -7,17 +7,37 @@ uniform sampler2D scene;
 uniform sampler2D bloomBlur;
 uniform bool bloom;
 uniform float exposure;
+// the scene may be smaller than the screen (dynamic resolution); when it is, the bilinear
+// upscale is sharpened by this much, 0 = plain bilinear
+uniform float sharpness;
+
+vec3 toneMap(vec3 hdrColor)
+{
+    return vec3(1.0) - exp(-hdrColor * exposure);
+}
 
 void main()
 {
     const float gamma = 2.2;
     vec3 hdrColor = texture(scene, TexCoords).rgb;
     vec3 bloomColor = texture(bloomBlur, TexCoords).rgb;
-    if(bloom)
-        hdrColor += bloomColor; // additive blending
     // tone mapping
-    vec3 result = vec3(1.0) - exp(-hdrColor * exposure);
+    vec3 result = toneMap(bloom ? hdrColor + bloomColor : hdrColor);
+    if (sharpness > 0.0) {
+        // unsharp mask over the four neighbours one scene texel away, in tonemapped space so
+        // bright highlights don't ring; clamped to the neighbourhood so edges don't overshoot
+        vec2 texel = 1.0 / vec2(textureSize(scene, 0));
+        vec3 center = toneMap(hdrColor);
+        vec3 north = toneMap(texture(scene, TexCoords + vec2(0.0, texel.y)).rgb);
+        vec3 south = toneMap(texture(scene, TexCoords - vec2(0.0, texel.y)).rgb);
+        vec3 east = toneMap(texture(scene, TexCoords + vec2(texel.x, 0.0)).rgb);
+        vec3 west = toneMap(texture(scene, TexCoords - vec2(texel.x, 0.0)).rgb);
+        vec3 lowest = min(center, min(min(north, south), min(east, west)));
+        vec3 highest = max(center, max(max(north, south), max(east, west)));
+        vec3 detail = center - (north + south + east + west) * 0.25;
+        result = clamp(result + detail * sharpness, lowest, max(highest, result));
+    }
     // also gamma correct while we're at it
     result = pow(result, vec3(1.0 / gamma));
     FragColor = vec4(result, 1.0);
-}
\ No newline at end of file
+}
@@ -0,0 +1,24 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D source;
+uniform vec2 sourceTexelSize;
+uniform float filterRadius;
+
+void main()
+{
+    // 3x3 tent filter, added onto the larger level by the blend state
+    vec2 r = sourceTexelSize * filterRadius;
+    vec3 result = texture(source, TexCoords).rgb * 4.0;
+    result += texture(source, TexCoords + vec2(-r.x, 0.0)).rgb * 2.0;
+    result += texture(source, TexCoords + vec2( r.x, 0.0)).rgb * 2.0;
+    result += texture(source, TexCoords + vec2(0.0, -r.y)).rgb * 2.0;
+    result += texture(source, TexCoords + vec2(0.0,  r.y)).rgb * 2.0;
+    result += texture(source, TexCoords + vec2(-r.x, -r.y)).rgb;
+    result += texture(source, TexCoords + vec2( r.x, -r.y)).rgb;
+    result += texture(source, TexCoords + vec2(-r.x,  r.y)).rgb;
+    result += texture(source, TexCoords + vec2( r.x,  r.y)).rgb;
+    FragColor = vec4(result / 16.0, 1.0);
+}
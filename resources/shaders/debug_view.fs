@@ -0,0 +1,16 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D source;
+// single channel textures are shown as grey
+uniform bool grey;
+
+void main()
+{
+    vec3 color = texture(source, TexCoords).rgb;
+    if (grey)
+        color = vec3(color.r);
+    FragColor = vec4(color, 1.0);
+}
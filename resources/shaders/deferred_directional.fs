@@ -0,0 +1,89 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+struct DirLight {
+    vec3 direction;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+struct PointLight {
+    vec3 position;
+    float constant;
+    vec3 ambient;
+    float linear;
+    vec3 diffuse;
+    float quadratic;
+    vec3 specular;
+};
+
+struct Light {
+    vec3 Position;
+    vec3 Color;
+};
+
+layout (std140) uniform LightData {
+    DirLight dirLight;
+    PointLight pointLight;
+    Light lights[4];
+};
+
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 cameraPosition;
+    float time;
+    float deltaTime;
+};
+
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedoSpec;
+uniform sampler2D gDepth;
+uniform sampler2D ambientOcclusion;
+
+uniform mat4 inverseViewProjection;
+uniform float shininess;
+
+vec3 decodeNormal(vec2 f)
+{
+    vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+void main()
+{
+    float depth = texture(gDepth, TexCoords).r;
+    if (depth == 1.0)
+        discard;    // sky, the skybox fills it later
+    vec4 world = inverseViewProjection * vec4(vec3(TexCoords, depth) * 2.0 - 1.0, 1.0);
+    vec3 fragPos = world.xyz / world.w;
+    vec3 normal = decodeNormal(texture(gNormal, TexCoords).rg);
+    vec4 albedoSpec = texture(gAlbedoSpec, TexCoords);
+    vec3 albedo = albedoSpec.rgb;
+    float ao = texture(ambientOcclusion, TexCoords).r;
+    vec3 viewDir = normalize(cameraPosition - fragPos);
+
+    // directional light
+    vec3 lightDir = normalize(-dirLight.direction);
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+    vec3 result = dirLight.ambient * albedo * ao;
+    result += dirLight.diffuse * max(dot(normal, lightDir), 0.0) * albedo;
+    result += dirLight.specular * pow(max(dot(normal, halfwayDir), 0.0), shininess) * albedoSpec.a;
+
+    // the scene-wide point light, unbounded so it stays out of the light volumes
+    lightDir = normalize(pointLight.position - fragPos);
+    halfwayDir = normalize(lightDir + viewDir);
+    float distance = length(pointLight.position - fragPos);
+    float attenuation = 1.0 / (pointLight.constant + pointLight.linear * distance + pointLight.quadratic * (distance * distance));
+    vec3 point = pointLight.ambient * albedo * ao;
+    point += pointLight.diffuse * max(dot(normal, lightDir), 0.0) * albedo;
+    point += pointLight.specular * pow(max(dot(normal, halfwayDir), 0.0), shininess) * albedoSpec.a;
+    result += point * attenuation;
+
+    FragColor = vec4(result, 1.0);
+}
@@ -0,0 +1,38 @@
+#version 330 core
+layout (location = 0) out vec2 gNormal;
+layout (location = 1) out vec4 gAlbedoSpec;
+
+struct Material {
+    sampler2D texture_diffuse1;
+    sampler2D texture_specular1;
+    vec4 diffuseFactor;
+};
+
+in vec2 TexCoords;
+in vec3 Normal;
+
+uniform Material material;
+
+// octahedral mapping: the unit sphere folded onto a square, two components per normal
+vec2 octWrap(vec2 v)
+{
+    return (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+vec2 encodeNormal(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    return n.z >= 0.0 ? n.xy : octWrap(n.xy);
+}
+
+void main()
+{
+    vec4 albedo = texture(material.texture_diffuse1, TexCoords) * material.diffuseFactor;
+#ifdef ALPHA_TEST
+    if(albedo.a < 0.4) {
+        discard;
+    }
+#endif
+    gNormal = encodeNormal(normalize(Normal));
+    gAlbedoSpec = vec4(albedo.rgb, texture(material.texture_specular1, TexCoords).r);
+}
@@ -0,0 +1,54 @@
+#version 330 core
+out vec4 FragColor;
+
+flat in vec4 light;
+flat in vec3 color;
+
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedoSpec;
+uniform sampler2D gDepth;
+
+uniform mat4 inverseViewProjection;
+uniform float shininess;
+
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 cameraPosition;
+    float time;
+    float deltaTime;
+};
+
+vec3 decodeNormal(vec2 f)
+{
+    vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+void main()
+{
+    vec2 uv = gl_FragCoord.xy / vec2(textureSize(gDepth, 0));
+    float depth = texture(gDepth, uv).r;
+    vec4 world = inverseViewProjection * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+    vec3 fragPos = world.xyz / world.w;
+
+    vec3 toLight = light.xyz - fragPos;
+    float distance = length(toLight);
+    if (distance >= light.w)
+        discard;
+    // inverse square with a window that reaches zero at the radius, so the volume has no visible edge
+    float window = clamp(1.0 - pow(distance / light.w, 4.0), 0.0, 1.0);
+    float attenuation = window * window / (distance * distance + 1.0);
+
+    vec3 normal = decodeNormal(texture(gNormal, uv).rg);
+    vec4 albedoSpec = texture(gAlbedoSpec, uv);
+    vec3 lightDir = toLight / distance;
+    vec3 viewDir = normalize(cameraPosition - fragPos);
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+    vec3 diffuse = max(dot(normal, lightDir), 0.0) * albedoSpec.rgb;
+    vec3 specular = vec3(pow(max(dot(normal, halfwayDir), 0.0), shininess) * albedoSpec.a);
+
+    FragColor = vec4(color * (diffuse + specular) * attenuation, 1.0);
+}
@@ -0,0 +1,23 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+// per instance: xyz position, w radius
+layout (location = 1) in vec4 aLight;
+layout (location = 2) in vec3 aColor;
+
+flat out vec4 light;
+flat out vec3 color;
+
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 cameraPosition;
+    float time;
+    float deltaTime;
+};
+
+void main()
+{
+    light = aLight;
+    color = aColor;
+    gl_Position = projection * view * vec4(aLight.xyz + aPos * aLight.w, 1.0);
+}
@@ -0,0 +1,21 @@
+#version 330 core
+
+in vec2 TexCoords;
+
+#ifdef ALPHA_TEST
+struct Material {
+    sampler2D texture_diffuse1;
+    vec4 diffuseFactor;
+};
+
+uniform Material material;
+#endif
+
+void main()
+{
+#ifdef ALPHA_TEST
+    // same cutoff as 2.model_lighting.fs
+    if(texture(material.texture_diffuse1, TexCoords).a * material.diffuseFactor.a < 0.4)
+        discard;
+#endif
+}
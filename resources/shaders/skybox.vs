@@ -3,12 +3,18 @@ layout (location = 0) in vec3 aPos;
 
 out vec3 TexCoords;
 
-uniform mat4 projection;
-uniform mat4 view;
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 cameraPosition;
+    float time;
+    float deltaTime;
+};
 
 void main()
 {
      TexCoords = aPos;
-     vec4 pos = projection * view * vec4(aPos, 1.0);
+     // drop the translation so the skybox stays centered on the camera
+     vec4 pos = projection * mat4(mat3(view)) * vec4(aPos, 1.0);
      gl_Position = pos.xyww;
 }
\ No newline at end of file
@@ -1,29 +1,57 @@
 #version 330 core
-out float FragColor;
+// r: ambient occlusion, g: linear view depth for the depth-aware upsample
+out vec2 FragColor;
 
 in vec2 TexCoords;
 
-uniform sampler2D gPosition;
-uniform sampler2D gNormal;
+uniform sampler2D depthMap;
 uniform sampler2D texNoise;
 
-uniform vec3 samples[64];
+uniform mat4 inverseProjection;
+// tile noise texture over the (half resolution) target, target size divided by noise size
+uniform vec2 noiseScale;
+uniform int sampleCount;
+uniform float radius;
+uniform float bias;
+uniform float power;
 
-// parameters (you'd probably want to use them as uniforms to more easily tweak the effect)
-int kernelSize = 64;
-float radius = 0.5;
-float bias = 0.025;
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 cameraPosition;
+    float time;
+    float deltaTime;
+};
 
-// tile noise texture over screen based on screen dimensions divided by noise size
-const vec2 noiseScale = vec2(800.0/4.0, 600.0/4.0);
+layout (std140) uniform SSAOKernel {
+    vec4 samples[64];
+};
 
-uniform mat4 projection;
+vec3 viewPosition(vec2 uv)
+{
+    vec4 clip = vec4(vec3(uv, texture(depthMap, uv).r) * 2.0 - 1.0, 1.0);
+    vec4 position = inverseProjection * clip;
+    return position.xyz / position.w;
+}
+
+// view-space z of the depth buffer at uv, cheaper than a full unprojection
+float viewDepth(vec2 uv)
+{
+    float ndc = texture(depthMap, uv).r * 2.0 - 1.0;
+    return -projection[3][2] / (ndc + projection[2][2]);
+}
 
 void main()
 {
-    // get input for SSAO algorithm
-    vec3 fragPos = texture(gPosition, TexCoords).xyz;
-    vec3 normal = normalize(texture(gNormal, TexCoords).rgb);
+    vec3 fragPos = viewPosition(TexCoords);
+    // face normal from the screen-space derivatives of the reconstructed position
+    vec3 normal = normalize(cross(dFdx(fragPos), dFdy(fragPos)));
+    if (texture(depthMap, TexCoords).r == 1.0) {
+        // sky, nothing to occlude
+        FragColor = vec2(1.0, fragPos.z);
+        return;
+    }
+
     vec3 randomVec = normalize(texture(texNoise, TexCoords * noiseScale).xyz);
     // create TBN change-of-basis matrix: from tangent-space to view-space
     vec3 tangent = normalize(randomVec - normal * dot(randomVec, normal));
@@ -31,27 +59,22 @@ void main()
     mat3 TBN = mat3(tangent, bitangent, normal);
     // iterate over the sample kernel and calculate occlusion factor
     float occlusion = 0.0;
-    for(int i = 0; i < kernelSize; ++i)
+    for(int i = 0; i < sampleCount; ++i)
     {
         // get sample position
-        vec3 samplePos = TBN * samples[i]; // from tangent to view-space
-        samplePos = fragPos + samplePos * radius;
+        vec3 samplePos = fragPos + TBN * samples[i].xyz * radius;
 
         // project sample position (to sample texture) (to get position on screen/texture)
-        vec4 offset = vec4(samplePos, 1.0);
-        offset = projection * offset; // from view to clip-space
-        offset.xyz /= offset.w; // perspective divide
-        offset.xyz = offset.xyz * 0.5 + 0.5; // transform to range 0.0 - 1.0
+        vec4 offset = projection * vec4(samplePos, 1.0);
+        offset.xy = offset.xy / offset.w * 0.5 + 0.5;
 
-        // get sample depth
-        float sampleDepth = texture(gPosition, offset.xy).z; // get depth value of kernel sample
+        float sampleDepth = viewDepth(offset.xy);
 
         // range check & accumulate
         float rangeCheck = smoothstep(0.0, 1.0, radius / abs(fragPos.z - sampleDepth));
         occlusion += (sampleDepth >= samplePos.z + bias ? 1.0 : 0.0) * rangeCheck;
     }
-    occlusion = 1.0 - (occlusion / kernelSize);
+    occlusion = 1.0 - (occlusion / float(sampleCount));
 
-    FragColor = occlusion;
+    FragColor = vec2(pow(occlusion, power), fragPos.z);
 }
-
@@ -0,0 +1,42 @@
+#version 330 core
+out float FragColor;
+
+in vec2 TexCoords;
+
+// half resolution, r: occlusion, g: linear view depth
+uniform sampler2D aoInput;
+// full resolution scene depth
+uniform sampler2D depthMap;
+uniform float depthSharpness;
+
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 cameraPosition;
+    float time;
+    float deltaTime;
+};
+
+void main()
+{
+    float ndc = texture(depthMap, TexCoords).r * 2.0 - 1.0;
+    float depth = -projection[3][2] / (ndc + projection[2][2]);
+
+    // 4x4 box blur over the half resolution texels around this pixel; texels whose depth
+    // differs from ours belong to another surface and barely count, so edges stay sharp
+    vec2 texelSize = 1.0 / vec2(textureSize(aoInput, 0));
+    float result = 0.0;
+    float weightSum = 0.0;
+    for (int x = 0; x < 4; ++x)
+    {
+        for (int y = 0; y < 4; ++y)
+        {
+            vec2 offset = (vec2(float(x), float(y)) - 1.5) * texelSize;
+            vec2 ao = texture(aoInput, TexCoords + offset).rg;
+            float weight = exp(-depthSharpness * abs(ao.g - depth) / max(abs(depth), 0.001));
+            result += ao.r * weight;
+            weightSum += weight;
+        }
+    }
+    FragColor = weightSum > 0.0001 ? result / weightSum : texture(aoInput, TexCoords).r;
+}
@@ -13,7 +13,34 @@
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
-
+#include <rg/GLState.h>
+#include <rg/RenderTargetPool.h>
+#include <rg/UniformBlocks.h>
+#include <rg/DepthPrepass.h>
+#include <rg/GpuProfiler.h>
+#include <rg/RenderGraph.h>
+#include <rg/Effects.h>
+#include <rg/BloomEffect.h>
+#include <rg/SSAOEffect.h>
+#include <rg/Deferred.h>
+#include <rg/LightClusters.h>
+#include <rg/Trace.h>
+#include <rg/CommandLine.h>
+#include <rg/Headless.h>
+#include <rg/CameraPath.h>
+#include <rg/FrameStats.h>
+#include <rg/PerfHud.h>
+#include <rg/GLStats.h>
+#include <rg/GLDebug.h>
+#include <rg/GpuMemory.h>
+#include <rg/FramePacing.h>
+#include <rg/FramePipeline.h>
+#include <rg/DynamicResolution.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
 #include <iostream>
 #include <random>
 
@@ -29,16 +56,38 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
 
 unsigned int loadCubemap(vector<std::string> faces);
 unsigned int loadTexture(const char *path);
+unsigned int createWhiteTexture();
 
 void renderQuad();
 void renderCube();
+bool writePPM(const std::string &path, unsigned int framebuffer, unsigned int width, unsigned int height);
 
 // settings
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
-bool bloom = true;
+// current size of the default framebuffer, every render target follows it
+unsigned int framebufferWidth = SCR_WIDTH;
+unsigned int framebufferHeight = SCR_HEIGHT;
+
+enum RenderPath {
+    RENDER_FORWARD = 0,
+    RENDER_DEFERRED,
+    RENDER_CLUSTERED
+};
+RenderPath renderPath = RENDER_FORWARD;
+// small point lights scattered over the islands, lit by the deferred and clustered paths
+const unsigned int MAX_LANTERNS = 1024;
+int lanternCount = 256;
 float exposure = 1.0f;
 
+// what ends up on screen; the intermediate views let the graph cull everything they don't need
+enum OutputView {
+    OUTPUT_FINAL = 0,
+    OUTPUT_AMBIENT_OCCLUSION,
+    OUTPUT_BLOOM
+};
+OutputView outputView = OUTPUT_FINAL;
+
 
 // camera
 Camera camera(glm::vec3(0.0f, 0.0f, 5.0f));
@@ -46,12 +95,6 @@ float lastX = SCR_WIDTH / 2.0f;
 float lastY = SCR_HEIGHT / 2.0f;
 bool firstMouse = true;
 
-//ssao
-float ourLerp(float a, float b, float f)
-{
-    return a + f * (b - a);
-}
-
 // timing
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
@@ -126,119 +169,258 @@ void ProgramState::LoadFromFile(std::string filename) {
 }
 
 ProgramState *programState;
+rg::DepthPrepass *depthPrepass;
+rg::RenderTargetPool *renderTargets;
+rg::RenderGraph *renderGraph;
+rg::DynamicResolution *dynamicResolution;
+rg::LightClusters *lightClusters;
+rg::PerfHud *perfHud;
+rg::FramePacer framePacer;
+rg::LatencyMeter *latencyMeter;
+// the next frame is updated on its own thread while this one is submitted, see rg::FramePipeline;
+// off by default, since the frame on screen then shows the input read a frame earlier
+bool pipelinedUpdate = false;
+// a --replay drives the camera, mouse and keyboard leave it alone
+bool replayingCameraPath = false;
+
+// one model instance drawn this frame
+struct SceneObject {
+    Model *model;
+    glm::mat4 transform;
+    float viewDepth = 0.0f;    // distance along the view direction, sort key
+};
+
+// a light hanging at a fixed offset from one of the scene objects, bobbing with it
+struct Lantern {
+    unsigned int object;
+    glm::vec3 offset;
+    glm::vec3 color;
+    float radius;
+    float phase;
+};
+
+// one blended mesh, sorted back to front across all objects
+struct BlendedDraw {
+    const SceneObject *object;
+    unsigned int mesh;
+    float viewDepth;
+};
+
+// one frame as the update leaves it for the render thread, see updateFrame in main()
+struct SimulatedFrame {
+    // inputs, filled in on the render thread before the update starts
+    float time = 0.0f;
+    float deltaTime = 0.0f;     // since the frame updated before it
+    Camera camera;
+    float aspect = 1.0f;
+    bool drawLanterns = false;
+    int lanternCount = 0;
+    GLint64 latched = 0;        // LatencyMeter::latch() when the input was read
+
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    std::vector<SceneObject> objects;       // the visible ones, front to back
+    unsigned int culledObjects = 0;
+    std::vector<rg::PointLightInstance> pointLights;
+    rg::LightGrid lightGrid;
+    std::vector<BlendedDraw> blendedDraws;  // back to front
+};
 
 void DrawImGui(ProgramState *programState);
 
-int main() {
-    // glfw: initialize and configure
-    // ------------------------------
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+int main(int argc, char **argv) {
+    RG_TRACE_THREAD_NAME("render");
+    rg::Options options;
+    std::string error;
+    if (!rg::parseCommandLine(argc, argv, options, error)) {
+        if (!error.empty())
+            std::cout << error << "\n";
+        std::cout << rg::usage();
+        return error.empty() ? 0 : -1;
+    }
+    const bool headless = options.headless;
+
+    // a replay flies the recorded path on a fixed time step, so every run draws the same frames
+    rg::CameraPath cameraPath;
+    const bool replaying = !options.replay.empty();
+    replayingCameraPath = replaying;
+    if (replaying) {
+        if (!cameraPath.load(options.replay, error)) {
+            std::cout << "Failed to load the camera path: " << error << std::endl;
+            return -1;
+        }
+        if (options.frames == 0)
+            options.frames = (unsigned int) std::ceil(cameraPath.duration() * 60.0f) + 1;
+    }
+    const bool fixedTimestep = headless || replaying;
+
+    // either a window or, headless, an offscreen context with no window, input or ImGui
+    GLFWwindow *window = NULL;
+    rg::HeadlessContext headlessContext;
+    GLADloadproc loadProc;
+    if (headless) {
+        if (!headlessContext.create(error)) {
+            std::cout << "Failed to create a headless context: " << error << std::endl;
+            return -1;
+        }
+        loadProc = (GLADloadproc) rg::HeadlessContext::getProcAddress;
+        if (!gladLoadGLLoader(loadProc)) {
+            std::cout << "Failed to initialize GLAD" << std::endl;
+            return -1;
+        }
+    } else {
+        // glfw: initialize and configure
+        // ------------------------------
+        glfwInit();
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
 #ifdef __APPLE__
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+#ifdef RG_GL_DEBUG
+        glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
 #endif
 
-    // glfw window creation
-    // --------------------
-    GLFWwindow *window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "FeelGoodInc", NULL, NULL);
-    if (window == NULL) {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return -1;
+        // glfw window creation
+        // --------------------
+        window = glfwCreateWindow(options.width, options.height, "FeelGoodInc", NULL, NULL);
+        if (window == NULL) {
+            std::cout << "Failed to create GLFW window" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+        glfwMakeContextCurrent(window);
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+        glfwSetCursorPosCallback(window, mouse_callback);
+        glfwSetScrollCallback(window, scroll_callback);
+        glfwSetKeyCallback(window, key_callback);
+        // tell GLFW to capture our mouse
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+        // glad: load all OpenGL function pointers
+        // ---------------------------------------
+        loadProc = (GLADloadproc) glfwGetProcAddress;
+        if (!gladLoadGLLoader(loadProc)) {
+            std::cout << "Failed to initialize GLAD" << std::endl;
+            return -1;
+        }
     }
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    glfwSetCursorPosCallback(window, mouse_callback);
-    glfwSetScrollCallback(window, scroll_callback);
-    glfwSetKeyCallback(window, key_callback);
-    // tell GLFW to capture our mouse
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-
-    // glad: load all OpenGL function pointers
-    // ---------------------------------------
-    if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
-        std::cout << "Failed to initialize GLAD" << std::endl;
-        return -1;
+
+#ifdef RG_GL_DEBUG
+    {
+        const rg::GLDebug::Severity severity = options.glDebug == "high" ? rg::GLDebug::HIGH
+                                               : options.glDebug == "low" ? rg::GLDebug::LOW
+                                               : options.glDebug == "notification" ? rg::GLDebug::NOTIFICATION
+                                               : rg::GLDebug::MEDIUM;
+        if (!rg::glDebug().install(loadProc, severity, error))
+            std::cout << "No GL debug output: " << error << std::endl;
     }
+#endif
 
     // tell stb_image.h to flip loaded texture's on the y-axis (before loading model).
     stbi_set_flip_vertically_on_load(true);
 
     programState = new ProgramState;
-    programState->LoadFromFile("resources/program_state.txt");
-    if (programState->ImGuiEnabled) {
-        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+    programState->LoadFromFile(options.scene);
+    if (headless)
+        programState->ImGuiEnabled = false;
+    if (options.renderPath == "deferred")
+        renderPath = RENDER_DEFERRED;
+    else if (options.renderPath == "clustered")
+        renderPath = RENDER_CLUSTERED;
+    else if (options.renderPath == "forward")
+        renderPath = RENDER_FORWARD;
+
+    if (!headless) {
+        if (programState->ImGuiEnabled) {
+            glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+        }
+        // Init Imgui
+        IMGUI_CHECKVERSION();
+        ImGui::CreateContext();
+        ImGuiIO &io = ImGui::GetIO();
+        (void) io;
+
+        ImGui_ImplGlfw_InitForOpenGL(window, true);
+        ImGui_ImplOpenGL3_Init("#version 330 core");
     }
-    // Init Imgui
-    IMGUI_CHECKVERSION();
-    ImGui::CreateContext();
-    ImGuiIO &io = ImGui::GetIO();
-    (void) io;
-
-
-
-    ImGui_ImplGlfw_InitForOpenGL(window, true);
-    ImGui_ImplOpenGL3_Init("#version 330 core");
 
     // configure global opengl state
     // -----------------------------
-    glEnable(GL_DEPTH_TEST);
+    rg::GLState& glState = rg::glState();
+    glState.enable(GL_DEPTH_TEST);
 
-    //blending
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    // blending stays off, only the passes that blend turn it on
+    glState.disable(GL_BLEND);
 
     // build and compile shaders
     // -------------------------
+    // opaque variant without discard (keeps early-Z), cutout variant with the alpha test compiled in
     Shader ourShader("resources/shaders/2.model_lighting.vs", "resources/shaders/2.model_lighting.fs");
+    Shader ourShaderCutout("resources/shaders/2.model_lighting.vs", "resources/shaders/2.model_lighting.fs", nullptr, "#define ALPHA_TEST\n");
+    Shader ourShaderBlend("resources/shaders/2.model_lighting.vs", "resources/shaders/2.model_lighting.fs", nullptr, "#define ALPHA_BLEND\n");
+    Shader prepassShader("resources/shaders/depth_prepass.vs", "resources/shaders/depth_prepass.fs");
+    Shader prepassCutoutShader("resources/shaders/depth_prepass.vs", "resources/shaders/depth_prepass.fs", nullptr, "#define ALPHA_TEST\n");
     Shader skyboxShader("resources/shaders/skybox.vs", "resources/shaders/skybox.fs");
-    Shader shaderBlur("resources/shaders/blur.vs", "resources/shaders/blur.fs");
     Shader shaderBloomFinal("resources/shaders/bloom_final.vs", "resources/shaders/bloom_final.fs");
     Shader shaderBloom("resources/shaders/bloom.vs", "resources/shaders/bloom.fs");
     Shader shaderLight("resources/shaders/bloom.vs", "resources/shaders/light_box.fs");
+    Shader debugViewShader("resources/shaders/bloom_final.vs", "resources/shaders/debug_view.fs");
+
+    Shader gBufferShader("resources/shaders/deferred_geometry.vs", "resources/shaders/deferred_geometry.fs");
+    Shader gBufferCutoutShader("resources/shaders/deferred_geometry.vs", "resources/shaders/deferred_geometry.fs", nullptr, "#define ALPHA_TEST\n");
 
-    Shader shaderGeometryPass("resources/shaders/ssao_geometry.vs", "resources/shaders/ssao_geometry.fs");
-    Shader shaderLightingPass("resources/shaders/ssao.vs", "resources/shaders/ssao_lighting.fs");
-    Shader shaderSSAO("resources/shaders/ssao.vs", "resources/shaders/ssao.fs");
-    Shader shaderSSAOBlur("resources/shaders/ssao.vs", "resources/shaders/ssao_blur.fs");
+    // one shininess for the whole scene, the materials don't carry their own
+    for (Shader *shader : {&ourShader, &ourShaderCutout, &ourShaderBlend}) {
+        shader->use();
+        shader->setFloat("material.shininessBP", 32.0f);
+        shader->setFloat("material.shininess", 8.0f);
+    }
 
     // load models
     // -----------
-    Model ourModel("resources/objects/floating_island(1)/scene.gltf");
-    ourModel.SetShaderTextureNamePrefix("material.");
-
-    Model airBoyModel("resources/objects/airman/scene.gltf");
-    airBoyModel.SetShaderTextureNamePrefix(("material."));
-
-    Model flyingLightHouse("resources/objects/flying_lighthouse/scene.gltf");
-    flyingLightHouse.SetShaderTextureNamePrefix("material.");
-
-    Model baseIsland("resources/objects/base_island/scene.gltf");
-    baseIsland.SetShaderTextureNamePrefix("material.");
-
-    Model model1OnBaseIsland("resources/objects/steampunk_lighthouse/scene.gltf");
-    model1OnBaseIsland.SetShaderTextureNamePrefix("material.");
-
-    Model model2OnBaseIsland("resources/objects/da_vincis_-_flying_machine/scene.gltf");
-    model2OnBaseIsland.SetShaderTextureNamePrefix("material.");
-
-    Model treeModel("resources/objects/platano_tree/scene.gltf");
-    treeModel.SetShaderTextureNamePrefix("material.");
-
-    Model tree2Model("resources/objects/trees_low_poly/scene.gltf");
-    tree2Model.SetShaderTextureNamePrefix("material.");
-
-    Model windmillModel("resources/objects/mill-wind/scene.gltf");
-    windmillModel.SetShaderTextureNamePrefix("material.");
-
-    Model giraffeModel("resources/objects/alpaca_non-commercial/scene.gltf");
-    giraffeModel.SetShaderTextureNamePrefix("material.");
-
-    Model bigTreeModel("resources/objects/low_poly_tree_scene_free/scene.gltf");
-    bigTreeModel.SetShaderTextureNamePrefix("material.");
+    // the block ends the trace zone once they're loaded, each model has its own zone inside it
+    const char *modelPaths[] = {
+            "resources/objects/floating_island(1)/scene.gltf",
+            "resources/objects/airman/scene.gltf",
+            "resources/objects/flying_lighthouse/scene.gltf",
+            "resources/objects/base_island/scene.gltf",
+            "resources/objects/steampunk_lighthouse/scene.gltf",
+            "resources/objects/da_vincis_-_flying_machine/scene.gltf",
+            "resources/objects/platano_tree/scene.gltf",
+            "resources/objects/trees_low_poly/scene.gltf",
+            "resources/objects/mill-wind/scene.gltf",
+            "resources/objects/alpaca_non-commercial/scene.gltf",
+            "resources/objects/low_poly_tree_scene_free/scene.gltf",
+    };
+    std::unique_ptr<Model> loadedModels[sizeof(modelPaths) / sizeof(modelPaths[0])];
+    {
+        RG_TRACE_ZONE("Load models");
+        for (unsigned int i = 0; i < sizeof(modelPaths) / sizeof(modelPaths[0]); i++) {
+            loadedModels[i].reset(new Model(modelPaths[i]));
+            loadedModels[i]->SetShaderTextureNamePrefix("material.");
+        }
+    }
+    Model &ourModel = *loadedModels[0];
+    Model &airBoyModel = *loadedModels[1];
+    Model &flyingLightHouse = *loadedModels[2];
+    Model &baseIsland = *loadedModels[3];
+    Model &model1OnBaseIsland = *loadedModels[4];
+    Model &model2OnBaseIsland = *loadedModels[5];
+    Model &treeModel = *loadedModels[6];
+    Model &tree2Model = *loadedModels[7];
+    Model &windmillModel = *loadedModels[8];
+    Model &giraffeModel = *loadedModels[9];
+    Model &bigTreeModel = *loadedModels[10];
+
+    // every model gets a row in the performance HUD, named after its folder
+    Model *models[] = {&ourModel, &airBoyModel, &flyingLightHouse, &baseIsland, &model1OnBaseIsland, &model2OnBaseIsland,
+                       &treeModel, &tree2Model, &windmillModel, &giraffeModel, &bigTreeModel};
+    perfHud = new rg::PerfHud;
+    for (Model *loaded : models)
+        perfHud->addModel(loaded->directory.substr(loaded->directory.find_last_of('/') + 1), &loaded->lastFrameCost);
 
     //skyBox
     float skyboxVertices[] = {
@@ -293,6 +475,7 @@ int main() {
     glBindVertexArray(skyBoxVAO);
     glBindBuffer(GL_ARRAY_BUFFER, skyBoxVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
+    rg::gpuMemory().trackBuffer(skyBoxVBO, sizeof(skyboxVertices), RG_GPU_MEMORY_SITE, "skybox");
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
 
@@ -342,252 +525,143 @@ int main() {
     lightColors.push_back(glm::vec3(5.0f, 5.0f, 5.0f));
     lightColors.push_back(glm::vec3(5.0f, 5.0f, 5.0f));
 //-----------------------------------------------------------------------------------
-    //bloom
-    // configure (floating point) framebuffers
-    // ---------------------------------------
-    unsigned int hdrFBO;
-    glGenFramebuffers(1, &hdrFBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
-    // create 2 floating point color buffers (1 for normal rendering, other for brightness threshold values)
-    unsigned int colorBuffers[2];
-    glGenTextures(2, colorBuffers);
-    for (unsigned int i = 0; i < 2; i++)
-    {
-        glBindTexture(GL_TEXTURE_2D, colorBuffers[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);  // we clamp to the edge as the blur filter would otherwise sample repeated texture values!
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        // attach texture to framebuffer
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, colorBuffers[i], 0);
+    // every render target (scene, g-buffer, SSAO, bloom) is acquired per frame at the current size
+    if (headless) {
+        framebufferWidth = options.width;
+        framebufferHeight = options.height;
+    } else {
+        int initialWidth, initialHeight;
+        glfwGetFramebufferSize(window, &initialWidth, &initialHeight);
+        framebufferWidth = (unsigned int) initialWidth;
+        framebufferHeight = (unsigned int) initialHeight;
     }
-    // create and attach depth buffer (renderbuffer)
-    unsigned int rboDepth;
-    glGenRenderbuffers(1, &rboDepth);
-    glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, SCR_WIDTH, SCR_HEIGHT);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
-    // tell OpenGL which color attachments we'll use (of this framebuffer) for rendering
-    unsigned int attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
-    glDrawBuffers(2, attachments);
-    // finally check if framebuffer is complete
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cout << "Framebuffer not complete!" << std::endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    // ping-pong-framebuffer for blurring
-    unsigned int pingpongFBO[2];
-    unsigned int pingpongColorbuffers[2];
-    glGenFramebuffers(2, pingpongFBO);
-    glGenTextures(2, pingpongColorbuffers);
-    for (unsigned int i = 0; i < 2; i++)
-    {
-        glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[i]);
-        glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // we clamp to the edge as the blur filter would otherwise sample repeated texture values!
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pingpongColorbuffers[i], 0);
-        // also check if framebuffers are complete (no need for depth buffer)
-        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-            std::cout << "Framebuffer not complete!" << std::endl;
+    renderTargets = new rg::RenderTargetPool;
+
+    renderGraph = new rg::RenderGraph(*renderTargets);
+    // the scene renders at a fraction of the framebuffer size that keeps the GPU within budget;
+    // it measures through the GPU profiler, so without RG_GPU_PROFILER the scale stays put
+    dynamicResolution = new rg::DynamicResolution;
+    // headless frames should come out the same on every run
+    if (headless)
+        dynamicResolution->enabled = false;
+
+    // headless there's no default framebuffer, the tonemap writes into this texture instead
+    unsigned int offscreenTexture = 0;
+    unsigned int offscreenFBO = 0;
+    if (headless) {
+        glGenTextures(1, &offscreenTexture);
+        glBindTexture(GL_TEXTURE_2D, offscreenTexture);
+        RG_GL_LABEL(GL_TEXTURE, offscreenTexture, "backbuffer");
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, framebufferWidth, framebufferHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        rg::gpuMemory().trackTexture(offscreenTexture, framebufferWidth, framebufferHeight, GL_RGBA8, false,
+                                     RG_GPU_MEMORY_SITE, "backbuffer");
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glGenFramebuffers(1, &offscreenFBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, offscreenFBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, offscreenTexture, 0);
+        RG_GL_LABEL(GL_FRAMEBUFFER, offscreenFBO, "backbuffer");
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
     }
 
-//----------------------------------------------------------------------------------------
-    //ssao
-    // configure g-buffer framebuffer
-    // ------------------------------
-    unsigned int gBuffer;
-    glGenFramebuffers(1, &gBuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
-    unsigned int gPosition, gNormal, gAlbedo;
-    // position color buffer
-    glGenTextures(1, &gPosition);
-    glBindTexture(GL_TEXTURE_2D, gPosition);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gPosition, 0);
-    // normal color buffer
-    glGenTextures(1, &gNormal);
-    glBindTexture(GL_TEXTURE_2D, gNormal);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, gNormal, 0);
-    // color + specular color buffer
-    glGenTextures(1, &gAlbedo);
-    glBindTexture(GL_TEXTURE_2D, gAlbedo);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, gAlbedo, 0);
-    // tell OpenGL which color attachments we'll use (of this framebuffer) for rendering
-    unsigned int attachments2[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
-    glDrawBuffers(3, attachments2);
-    // create and attach depth buffer (renderbuffer)
-    unsigned int rboDepth2;
-    glGenRenderbuffers(1, &rboDepth2);
-    glBindRenderbuffer(GL_RENDERBUFFER, rboDepth2);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, SCR_WIDTH, SCR_HEIGHT);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth2);
-    // finally check if framebuffer is complete
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cout << "Framebuffer not complete!" << std::endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    // also create framebuffer to hold SSAO processing stage
-    // -----------------------------------------------------
-    unsigned int ssaoFBO, ssaoBlurFBO;
-    glGenFramebuffers(1, &ssaoFBO);  glGenFramebuffers(1, &ssaoBlurFBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, ssaoFBO);
-    unsigned int ssaoColorBuffer, ssaoColorBufferBlur;
-    // SSAO color buffer
-    glGenTextures(1, &ssaoColorBuffer);
-    glBindTexture(GL_TEXTURE_2D, ssaoColorBuffer);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, SCR_WIDTH, SCR_HEIGHT, 0, GL_RED, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, ssaoColorBuffer, 0);
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cout << "SSAO Framebuffer not complete!" << std::endl;
-    // and blur stage
-    glBindFramebuffer(GL_FRAMEBUFFER, ssaoBlurFBO);
-    glGenTextures(1, &ssaoColorBufferBlur);
-    glBindTexture(GL_TEXTURE_2D, ssaoColorBufferBlur);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, SCR_WIDTH, SCR_HEIGHT, 0, GL_RED, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, ssaoColorBufferBlur, 0);
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cout << "SSAO Blur Framebuffer not complete!" << std::endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    // generate sample kernel
-    // ----------------------
-    uniform_real_distribution<GLfloat> randomFloats(0.0, 1.0); // generates random floats between 0.0 and 1.0
-    std::default_random_engine generator;
-    std::vector<glm::vec3> ssaoKernel;
-    for (unsigned int i = 0; i < 64; ++i)
-    {
-        glm::vec3 sample(randomFloats(generator) * 2.0 - 1.0, randomFloats(generator) * 2.0 - 1.0, randomFloats(generator));
-        sample = glm::normalize(sample);
-        sample *= randomFloats(generator);
-        float scale = float(i) / 64.0f;
-
-        // scale samples s.t. they're more aligned to center of kernel
-        scale = ourLerp(0.1f, 1.0f, scale * scale);
-        sample *= scale;
-        ssaoKernel.push_back(sample);
-    }
+    // every effect whose header is included above (bloom, SSAO) registered itself
+    rg::EffectRegistry &effects = rg::effectRegistry();
+    effects.instantiate(*renderTargets);
+    // bound in place of ambient occlusion when no effect computes it
+    unsigned int whiteTexture = createWhiteTexture();
 
-    // generate noise texture
-    // ----------------------
-    std::vector<glm::vec3> ssaoNoise;
-    for (unsigned int i = 0; i < 16; i++)
+    // deferred path: light volumes over a compact g-buffer
+    rg::DeferredLighting deferredLighting;
+    std::vector<Lantern> lanterns;
     {
-        glm::vec3 noise(randomFloats(generator) * 2.0 - 1.0, randomFloats(generator) * 2.0 - 1.0, 0.0f); // rotate around z-axis (in tangent space)
-        ssaoNoise.push_back(noise);
+        std::default_random_engine generator;
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        for (unsigned int i = 0; i < MAX_LANTERNS; i++) {
+            Lantern lantern;
+            lantern.object = i;
+            float angle = unit(generator) * 6.2831853f;
+            float distance = 1.0f + unit(generator) * 4.0f;
+            lantern.offset = glm::vec3(cos(angle) * distance, -0.5f + unit(generator) * 3.0f, sin(angle) * distance);
+            lantern.color = glm::vec3(1.0f, 0.55f + unit(generator) * 0.25f, 0.2f + unit(generator) * 0.15f) * 3.0f;
+            lantern.radius = 1.0f + unit(generator) * 1.5f;
+            lantern.phase = unit(generator) * 6.2831853f;
+            lanterns.push_back(lantern);
+        }
     }
-    unsigned int noiseTexture; glGenTextures(1, &noiseTexture);
-    glBindTexture(GL_TEXTURE_2D, noiseTexture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, 4, 4, 0, GL_RGB, GL_FLOAT, &ssaoNoise[0]);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-    // lighting info
-    // -------------
-    glm::vec3 lightPos = glm::vec3(2.0, 4.0, -2.0);
-    glm::vec3 lightColor = glm::vec3(0.2, 0.2, 0.7);
+    // clustered forward path: lanterns binned per froxel, buffer textures after the AO unit
+    lightClusters = new rg::LightClusters(MATERIAL_SLOT_COUNT + 1);
 
 //----------------------------------------------------------------------------------------
     // shader configuration
     // --------------------
     shaderBloom.use();
     shaderBloom.setInt("diffuseTexture", 0);
-    shaderBlur.use();
-    shaderBlur.setInt("image", 0);
     shaderBloomFinal.use();
     shaderBloomFinal.setInt("scene", 0);
     shaderBloomFinal.setInt("bloomBlur", 1);
+    debugViewShader.use();
+    debugViewShader.setInt("source", 0);
+
+    // ambient occlusion goes on the first unit after the material slots
+    for (Shader *shader : {&ourShader, &ourShaderCutout, &ourShaderBlend}) {
+        shader->use();
+        shader->setInt("ambientOcclusion", MATERIAL_SLOT_COUNT);
+        lightClusters->bindSamplers(*shader);
+    }
 
-    shaderLightingPass.use();
-    shaderLightingPass.setInt("gPosition", 0);
-    shaderLightingPass.setInt("gNormal", 1);
-    shaderLightingPass.setInt("gAlbedo", 2);
-    shaderLightingPass.setInt("ssao", 3);
-    shaderSSAO.use();
-    shaderSSAO.setInt("gPosition", 0);
-    shaderSSAO.setInt("gNormal", 1);
-    shaderSSAO.setInt("texNoise", 2);
-    shaderSSAOBlur.use();
-    shaderSSAOBlur.setInt("ssaoInput", 0);
-
-    // render loop
-    // -----------
-    while (!glfwWindowShouldClose(window)) {
-        // per-frame time logic
-        // --------------------
-        float currentFrame = glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
-
-        // input
-        // -----
-        processInput(window);
-
-
-        // render
-        // ------
-        glClearColor(programState->clearColor.r, programState->clearColor.g, programState->clearColor.b, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // 1. render scene into floating point framebuffer
-        // -----------------------------------------------
-        glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // don't forget to enable shader before setting uniforms
-        ourShader.use();
-        // view/projection transformations
-        glm::mat4 projection = glm::perspective(glm::radians(programState->camera.Zoom),
-                                                (float) SCR_WIDTH / (float) SCR_HEIGHT, 0.1f, 100.0f);
-        glm::mat4 view = programState->camera.GetViewMatrix();
-        ourShader.setMat4("projection", projection);
-        ourShader.setMat4("view", view);
-
-        pointLight.position = glm::vec3(5.0f, 10.0f, -5.0f);
-        ourShader.setVec3("pointLight.position", pointLight.position);
-        ourShader.setVec3("pointLight.ambient", pointLight.ambient);
-        ourShader.setVec3("pointLight.diffuse", pointLight.diffuse);
-        ourShader.setVec3("pointLight.specular", pointLight.specular);
-        ourShader.setFloat("pointLight.constant", pointLight.constant);
-        ourShader.setFloat("pointLight.linear", pointLight.linear);
-        ourShader.setFloat("pointLight.quadratic", pointLight.quadratic);
-
-        ourShader.setVec3("viewPosition", programState->camera.Position);
-
-        ourShader.setFloat("material.shininessBP", 32.0f);
-        ourShader.setFloat("material.shininess", 8.0f);
-        ourShader.setInt("blinn", blinn);
-
-        ourShader.setVec3("dirLight.direction", dirLight.direction);
-        ourShader.setVec3("dirLight.ambient", dirLight.ambient);
-        ourShader.setVec3("dirLight.diffuse", dirLight.diffuse);
-        ourShader.setVec3("dirLight.specular", dirLight.specular);
-
-        glDepthFunc(GL_LEQUAL);
+    // camera and light data shared by every shader, one buffer write each per frame
+    rg::UniformBuffer<rg::FrameData> frameBuffer(rg::FRAME_DATA_BINDING);
+    rg::UniformBuffer<rg::LightData> lightBuffer(rg::LIGHT_DATA_BINDING);
+    rg::FrameData frameData = rg::FrameData();
+    rg::LightData lightData = rg::LightData();
+
+    depthPrepass = new rg::DepthPrepass;
+
+    // per-frame uniforms are set through handles resolved once here
+    const int ourModelLoc = ourShader.uniform("model");
+    const int gBufferModelLoc = gBufferShader.uniform("model");
+    const int gBufferCutoutModelLoc = gBufferCutoutShader.uniform("model");
+    const int ourCutoutModelLoc = ourShaderCutout.uniform("model");
+    const int ourBlendModelLoc = ourShaderBlend.uniform("model");
+    const int prepassModelLoc = prepassShader.uniform("model");
+    const int prepassCutoutModelLoc = prepassCutoutShader.uniform("model");
+    const int lightModelLoc = shaderLight.uniform("model");
+    const int lightColorLoc = shaderLight.uniform("lightColor");
+    const int bloomFinalBloomLoc = shaderBloomFinal.uniform("bloom");
+    const int bloomFinalExposureLoc = shaderBloomFinal.uniform("exposure");
+    const int bloomFinalSharpnessLoc = shaderBloomFinal.uniform("sharpness");
+    const int debugViewGreyLoc = debugViewShader.uniform("grey");
+
+    // loaders above bind buffers, textures and framebuffers directly
+    glState.invalidate();
+
+    rg::gpuMemory().setBudget((size_t) options.vramBudget * 1024 * 1024);
+    framePacer.mode = options.pacing;
+    framePacer.targetFps = (float) options.fps;
+
+#ifdef RG_GL_STATS
+    // from here on, so loading doesn't end up in the first frame
+    rg::glStats().keepHistory(!options.glStats.empty());
+    rg::glStats().install();
+#endif
 
-        //Face culling
-        glEnable(GL_CULL_FACE);
-        glCullFace(GL_BACK);
+    // swap interval -1 tears a late frame instead of waiting for the next refresh, where supported
+    const bool adaptiveSwapSupported = !headless && (glfwExtensionSupported("GLX_EXT_swap_control_tear") ||
+                                                     glfwExtensionSupported("WGL_EXT_swap_control_tear"));
+    rg::PacingMode appliedPacing = rg::PACING_MODE_COUNT;
+    latencyMeter = new rg::LatencyMeter;
+    pipelinedUpdate = options.pipelined;
+
+    // Everything of a frame that needs no GL: the animation, the lanterns, the light grid,
+    // culling and the draw order. Runs on the update thread a frame ahead of the render thread
+    // (or right before the frame is submitted, unthreaded), so it reads nothing but the models,
+    // the lanterns and the inputs put into the frame before it started.
+    const float zNear = 0.1f, zFar = 100.0f;
+    auto updateFrame = [&](SimulatedFrame &frame) {
+        const float currentFrame = frame.time;
+        std::vector<SceneObject> &sceneObjects = frame.objects;
+        sceneObjects.clear();
 
         //First small island render
         glm::mat4 model = glm::mat4(1.0f);
@@ -595,16 +669,14 @@ int main() {
                                glm::vec3 (68,-11+cos(currentFrame)*0.4f,20)); // translate it down so it's at the center of the scene
         model = glm::scale(model, glm::vec3(0.1f));    // it's a bit too big for our scene, so scale it down
         model = glm::rotate(model, glm::radians(45.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        ourShader.setMat4("model", model);
-        ourModel.Draw(ourShader);
+        sceneObjects.push_back(SceneObject{&ourModel, model});
 
         //Second mini-floating island render
         glm::mat4 model0 = glm::mat4(1.0f);
         model0 = glm::translate(model0,
                                 glm::vec3 (86,-15+cos(currentFrame)*0.2f,32)); // translate it down so it's at the center of the scene
         model0 = glm::scale(model0, glm::vec3(0.08f));
-        ourShader.setMat4("model", model0);
-        ourModel.Draw(ourShader);
+        sceneObjects.push_back(SceneObject{&ourModel, model0});
 
 
         //Air boy render
@@ -612,16 +684,14 @@ int main() {
         model2 = glm::translate(model2,
                                 glm::vec3 (73,-8.6+cos(currentFrame)*0.4f,24));
         model2 = glm::scale(model2, glm::vec3(0.1f));
-        ourShader.setMat4("model", model2);
-        airBoyModel.Draw(ourShader);
+        sceneObjects.push_back(SceneObject{&airBoyModel, model2});
 
         //Base island render
         glm::mat4 model3 = glm::mat4(1.0f);
         model3 = glm::translate(model3,
                                 glm::vec3 (70,-15+cos(currentFrame)*0.1f,40));
         model3 = glm::scale(model3, glm::vec3(0.9f));
-        ourShader.setMat4("model", model3);
-        baseIsland.Draw(ourShader);
+        sceneObjects.push_back(SceneObject{&baseIsland, model3});
 
         //Model1 on base island render
         glm::mat4 model4 = glm::mat4(1.0f);
@@ -629,8 +699,7 @@ int main() {
                                 glm::vec3 (67.3,-14+cos(currentFrame)*0.1f,40.8));
         model4 = glm::rotate(model4, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
         model4 = glm::scale(model4, glm::vec3(0.01f));
-        ourShader.setMat4("model", model4);
-        model1OnBaseIsland.Draw(ourShader);
+        sceneObjects.push_back(SceneObject{&model1OnBaseIsland, model4});
 
 
 
@@ -640,8 +709,7 @@ int main() {
                                 glm::vec3 (86.2,-13.8+cos(currentFrame)*0.2f,40)); // translate it down so it's at the center of the scene
         model6 = glm::rotate(model6, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
         model6 = glm::scale(model6, glm::vec3(0.03f));
-        ourShader.setMat4("model", model6);
-        flyingLightHouse.Draw(ourShader);
+        sceneObjects.push_back(SceneObject{&flyingLightHouse, model6});
 
         //Tree render
         glm::mat4 tree1 = glm::mat4(1.0f);
@@ -649,8 +717,7 @@ int main() {
                                glm::vec3 (89,-13.5+cos(currentFrame)*0.2f,32));
         tree1 = glm::scale(tree1, glm::vec3(0.008f));
         tree1 = glm::rotate(tree1, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        ourShader.setMat4("model", tree1);
-        treeModel.Draw(ourShader);
+        sceneObjects.push_back(SceneObject{&treeModel, tree1});
 
         //Tree2 render
         glm::mat4 tree2 = glm::mat4(1.0f);
@@ -658,64 +725,56 @@ int main() {
                                glm::vec3 (75.5,-13.2+cos(currentFrame)*0.1f,43));
         tree2 = glm::rotate(tree2, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
         tree2 = glm::scale(tree2, glm::vec3(0.03f));
-        ourShader.setMat4("model", tree2);
-        tree2Model.Draw(ourShader);
+        sceneObjects.push_back(SceneObject{&tree2Model, tree2});
 
         glm::mat4 tree21 = glm::mat4(1.0f);
         tree21 = glm::translate(tree21,
                                 glm::vec3 (70.4,-13.5+cos(currentFrame)*0.1f,46));
         tree21 = glm::rotate(tree21, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
         tree21 = glm::scale(tree21, glm::vec3(0.025f));
-        ourShader.setMat4("model", tree21);
-        tree2Model.Draw(ourShader);
+        sceneObjects.push_back(SceneObject{&tree2Model, tree21});
 
         glm::mat4 tree22 = glm::mat4(1.0f);
         tree22 = glm::translate(tree22,
                                 glm::vec3 (69.4,-13.2+cos(currentFrame)*0.1f,45.2));
         tree22 = glm::rotate(tree22, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
         tree22 = glm::scale(tree22, glm::vec3(0.03f));
-        ourShader.setMat4("model", tree22);
-        tree2Model.Draw(ourShader);
+        sceneObjects.push_back(SceneObject{&tree2Model, tree22});
 
         glm::mat4 tree23 = glm::mat4(1.0f);
         tree23 = glm::translate(tree23,
                                 glm::vec3 (74,-13.2+cos(currentFrame)*0.1f,42));
         tree23 = glm::rotate(tree23, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
         tree23 = glm::scale(tree23, glm::vec3(0.008f));
-        ourShader.setMat4("model", tree23);
-        treeModel.Draw(ourShader);
+        sceneObjects.push_back(SceneObject{&treeModel, tree23});
 
         glm::mat4 tree24 = glm::mat4(1.0f);
         tree24 = glm::translate(tree24,
                                 glm::vec3 (69,-9.8+cos(currentFrame)*0.4f,14.2));
         tree24 = glm::rotate(tree24, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
         tree24 = glm::scale(tree24, glm::vec3(0.04f));
-        ourShader.setMat4("model", tree24);
-        tree2Model.Draw(ourShader);
+        sceneObjects.push_back(SceneObject{&tree2Model, tree24});
 
         glm::mat4 tree25 = glm::mat4(1.0f);
         tree25 = glm::translate(tree25,
                                glm::vec3 (87.5,-13.5+cos(currentFrame)*0.2f,31));
         tree25 = glm::scale(tree25, glm::vec3(0.005f));
         tree25 = glm::rotate(tree25, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        ourShader.setMat4("model", tree25);
-        treeModel.Draw(ourShader);
+        sceneObjects.push_back(SceneObject{&treeModel, tree25});
 
         glm::mat4 tree13 = glm::mat4(1.0f);
         tree13 = glm::translate(tree13,
                                 glm::vec3 (87.5,-13.9+cos(currentFrame)*0.2f,32));
         tree13 = glm::rotate(tree13, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
         tree13 = glm::scale(tree13, glm::vec3(0.02f));
-        ourShader.setMat4("model", tree13);
-        tree2Model.Draw(ourShader);
+        sceneObjects.push_back(SceneObject{&tree2Model, tree13});
 
         //Giraffe-alpaca render
         glm::mat4 giraffe = glm::mat4(1.0f);
         giraffe = glm::translate(giraffe,
                                 glm::vec3 (69,-9.25+cos(currentFrame)*0.4f,20));
         giraffe = glm::scale(giraffe, glm::vec3(0.5f));
-        ourShader.setMat4("model", giraffe);
-        giraffeModel.Draw(ourShader);
+        sceneObjects.push_back(SceneObject{&giraffeModel, giraffe});
 
 
         //Big tree render
@@ -724,151 +783,453 @@ int main() {
                               glm::vec3 (63.7,-13.4+cos(currentFrame)*0.1f,35));
         bigTree = glm::rotate(bigTree, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
         bigTree = glm::scale(bigTree, glm::vec3(0.2));
-        ourShader.setMat4("model", bigTree);
-        bigTreeModel.Draw(ourShader);
-
-        projection = glm::perspective(glm::radians(programState->camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        view = programState->camera.GetViewMatrix();
-        shaderBloom.use();
-        shaderBloom.setMat4("projection", projection);
-        shaderBloom.setMat4("view", view);
-
-        // set lighting uniforms
-        for (unsigned int i = 0; i < lightPositions.size(); i++) {
-            shaderBloom.setVec3("lights[" + std::to_string(i) + "].Position", lightPositions[i]);
-            shaderBloom.setVec3("lights[" + std::to_string(i) + "].Color", lightColors[i]);
+        sceneObjects.push_back(SceneObject{&bigTreeModel, bigTree});
+
+        // lanterns follow the object they were hung on, so place them before the list is sorted
+        std::vector<rg::PointLightInstance> &pointLights = frame.pointLights;
+        pointLights.clear();
+        if (frame.drawLanterns) {
+            for (int i = 0; i < frame.lanternCount && i < (int) lanterns.size(); i++) {
+                const Lantern &lantern = lanterns[i];
+                glm::vec3 anchor = glm::vec3(sceneObjects[lantern.object % sceneObjects.size()].transform[3]);
+                glm::vec3 sway = glm::vec3(0.0f, sin(currentFrame * 1.5f + lantern.phase) * 0.1f, 0.0f);
+                pointLights.push_back(rg::PointLightInstance{anchor + lantern.offset + sway, lantern.radius, lantern.color});
+            }
         }
-        shaderBloom.setVec3("viewPos", programState->camera.Position);
-
-        // light sources as white cubes
-        shaderLight.use();
-        shaderLight.setMat4("projection", projection);
-        shaderLight.setMat4("view", view);
-
-        for (unsigned int i = 0; i < lightPositions.size(); i++) {
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, glm::vec3(lightPositions[i]) + glm::vec3(0.0f, cos(currentFrame)*0.1f, 0.0f));
-            model = glm::scale(model, glm::vec3(0.18f));
-            shaderLight.setMat4("model", model);
-            shaderLight.setVec3("lightColor", lightColors[i]);
-            renderCube();
+
+        frame.projection = glm::perspective(glm::radians(frame.camera.Zoom), frame.aspect, zNear, zFar);
+        frame.view = frame.camera.GetViewMatrix();
+        const glm::mat4 &view = frame.view;
+
+        // the forward shaders (and the blended pass of the deferred path) read the lanterns from the grid
+        lightClusters->build(frame.lightGrid, pointLights, view, frame.projection, zNear, zFar);
+
+        // objects whose box is outside the view don't go to any pass; the lanterns above were
+        // placed from the full list, so it's only shortened now
+        const rg::Frustum frustum(frame.projection * view);
+        const unsigned int objectCount = (unsigned int) sceneObjects.size();
+        sceneObjects.erase(std::remove_if(sceneObjects.begin(), sceneObjects.end(), [&frustum](const SceneObject &object) {
+            return !frustum.intersects(object.model->bounds.transformed(object.transform));
+        }), sceneObjects.end());
+        frame.culledObjects = objectCount - (unsigned int) sceneObjects.size();
+
+        // opaque front to back so early-Z rejects as much as possible
+        for (SceneObject &object : sceneObjects)
+            object.viewDepth = -(view * object.transform[3]).z;
+        std::sort(sceneObjects.begin(), sceneObjects.end(), [](const SceneObject &a, const SceneObject &b) {
+            return a.viewDepth < b.viewDepth;
+        });
+
+        // blended meshes are drawn back to front across all objects
+        std::vector<BlendedDraw> &blendedDraws = frame.blendedDraws;
+        blendedDraws.clear();
+        for (const SceneObject &object : sceneObjects) {
+            if (!object.model->HasBlendedMeshes())
+                continue;
+            for (unsigned int i = 0; i < object.model->meshes.size(); i++) {
+                const Mesh &mesh = object.model->meshes[i];
+                if (mesh.GetAlphaMode() != ALPHA_BLEND)
+                    continue;
+                float depth = -(view * object.transform * glm::vec4(mesh.center, 1.0f)).z;
+                blendedDraws.push_back(BlendedDraw{&object, i, depth});
+            }
         }
+        std::sort(blendedDraws.begin(), blendedDraws.end(), [](const BlendedDraw &a, const BlendedDraw &b) {
+            return a.viewDepth > b.viewDepth;
+        });
+    };
 
-        glDisable(GL_CULL_FACE);
+    // the camera after this frame's input and the settings as they are now go to the next
+    // update, the one of the frame shown at time, step after the one before it
+    rg::FramePipeline<SimulatedFrame> pipeline(updateFrame, pipelinedUpdate);
+    auto startUpdate = [&](float time, float step) {
+        if (replaying)
+            cameraPath.apply(time, programState->camera);
+        else if (!options.record.empty())
+            cameraPath.record(time, programState->camera);
+        SimulatedFrame &frame = pipeline.next();
+        frame.time = time;
+        frame.deltaTime = step;
+        frame.camera = programState->camera;
+        frame.aspect = (float) framebufferWidth / (float) framebufferHeight;
+        frame.drawLanterns = renderPath != RENDER_FORWARD;
+        frame.lanternCount = lanternCount;
+        frame.latched = headless ? 0 : latencyMeter->latch();
+        pipeline.kick();
+    };
 
-        // skybox cube
-        skyboxShader.use();
-        view[3][0] = 0;
-        view[3][1] = 0;
-        view[3][2] = 0;
-        view[3][3] = 0;
-        skyboxShader.setMat4("view", view);
-        skyboxShader.setMat4("projection", projection);
+    // render loop
+    // -----------
+    unsigned int framesRendered = 0;
+    rg::FrameStats frameStats;
+    auto loopStart = std::chrono::steady_clock::now();
+    // the first frame's step counts from here, not from before the models were loaded
+    if (!fixedTimestep)
+        lastFrame = (float) glfwGetTime();
+    while (headless ? framesRendered < options.frames
+                    : !glfwWindowShouldClose(window) && (options.frames == 0 || framesRendered < options.frames)) {
+        RG_TRACE_ZONE("Frame");
+        if (pipeline.threaded() != pipelinedUpdate) {
+            pipeline.setThreaded(pipelinedUpdate);
+            latencyMeter->reset();
+        }
+        if (!headless) {
+            if (framePacer.mode != appliedPacing) {
+                glfwSwapInterval(framePacer.swapInterval(adaptiveSwapSupported));
+                appliedPacing = framePacer.mode;
+                latencyMeter->reset();
+            }
+            // the capped mode waits here, before the input is read, not before the swap
+            RG_TRACE_ZONE("FramePacer::wait");
+            framePacer.wait();
+        }
+        auto frameStart = std::chrono::steady_clock::now();
+        // per-frame time logic
+        // --------------------
+        // headless and replays step a fixed 60 Hz so the animation is the same on every run
+        float currentFrame = fixedTimestep ? framesRendered / 60.0f : (float) glfwGetTime();
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
 
-        glBindVertexArray(skyBoxVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        glBindVertexArray(0);
-        glDepthFunc(GL_LESS); // set depth function back to default
+        // nothing to draw into while minimized
+        if (framebufferWidth == 0 || framebufferHeight == 0) {
+            glfwWaitEvents();
+            continue;
+        }
+        rg::drawCounters() = rg::DrawCounters();
+        // everything up to the tonemap works at the scaled size, which keeps the aspect ratio
+        rg::GpuProfiler &profiler = rg::gpuProfiler();
+        profiler.beginFrame();
+        const unsigned int displayWidth = framebufferWidth;
+        const unsigned int displayHeight = framebufferHeight;
+        const unsigned int width = dynamicResolution->scaled(displayWidth);
+        const unsigned int height = dynamicResolution->scaled(displayHeight);
 
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
+        pointLight.position = glm::vec3(5.0f, 10.0f, -5.0f);
+        lightData.pointLight.position = pointLight.position;
+        lightData.pointLight.ambient = pointLight.ambient;
+        lightData.pointLight.diffuse = pointLight.diffuse;
+        lightData.pointLight.specular = pointLight.specular;
+        lightData.pointLight.constant = pointLight.constant;
+        lightData.pointLight.linear = pointLight.linear;
+        lightData.pointLight.quadratic = pointLight.quadratic;
+
+        lightData.dirLight.direction = dirLight.direction;
+        lightData.dirLight.ambient = dirLight.ambient;
+        lightData.dirLight.diffuse = dirLight.diffuse;
+        lightData.dirLight.specular = dirLight.specular;
+
+        for (unsigned int i = 0; i < lightPositions.size() && i < rg::MAX_BLOOM_LIGHTS; i++) {
+            lightData.lights[i].position = lightPositions[i];
+            lightData.lights[i].color = lightColors[i];
+        }
+        lightBuffer.update(lightData);
 
-        // 2. generate SSAO texture
-        // ------------------------
-//        glBindFramebuffer(GL_FRAMEBUFFER, ssaoFBO);
-//        glClear(GL_COLOR_BUFFER_BIT);
-//        shaderSSAO.use();
-//        // Send kernel + rotation
-//        for (unsigned int i = 0; i < 64; ++i)
-//            shaderSSAO.setVec3("samples[" + std::to_string(i) + "]", ssaoKernel[i]);
-//        shaderSSAO.setMat4("projection", projection);
-//        glActiveTexture(GL_TEXTURE0);
-//        glBindTexture(GL_TEXTURE_2D, gPosition);
-//        glActiveTexture(GL_TEXTURE1);
-//        glBindTexture(GL_TEXTURE_2D, gNormal);
-//        glActiveTexture(GL_TEXTURE2);
-//        glBindTexture(GL_TEXTURE_2D, noiseTexture);
-//        renderQuad();
-//        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-
-        // 3. blur SSAO texture to remove noise
-        // ------------------------------------
-//        glBindFramebuffer(GL_FRAMEBUFFER, ssaoBlurFBO);
-//        glClear(GL_COLOR_BUFFER_BIT);
-//        shaderSSAOBlur.use();
-//        glActiveTexture(GL_TEXTURE0);
-//        glBindTexture(GL_TEXTURE_2D, ssaoColorBuffer);
-//        renderQuad();
-//        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-
-        // 4. lighting pass: traditional deferred Blinn-Phong lighting with added screen-space ambient occlusion
-        // -----------------------------------------------------------------------------------------------------
-//        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-//        shaderLightingPass.use();
-//        // send light relevant uniforms
-//        glm::vec3 lightPosView = glm::vec3(camera.GetViewMatrix() * glm::vec4(lightPos, 1.0));
-//        shaderLightingPass.setVec3("light.Position", lightPosView);
-//        shaderLightingPass.setVec3("light.Color", lightColor);
-//        // Update attenuation parameters
-//        const float linear    = 0.09f;
-//        const float quadratic = 0.032f;
-//        shaderLightingPass.setFloat("light.Linear", linear);
-//        shaderLightingPass.setFloat("light.Quadratic", quadratic);
-//        glActiveTexture(GL_TEXTURE0);
-//        glBindTexture(GL_TEXTURE_2D, gPosition);
-//        glActiveTexture(GL_TEXTURE1);
-//        glBindTexture(GL_TEXTURE_2D, gNormal);
-//        glActiveTexture(GL_TEXTURE2);
-//        glBindTexture(GL_TEXTURE_2D, gAlbedo);
-//        glActiveTexture(GL_TEXTURE3); // add extra SSAO texture to lighting pass
-//        glBindTexture(GL_TEXTURE_2D, ssaoColorBufferBlur);
-//        renderQuad();
-
-
-        // 2. blur bright fragments with two-pass Gaussian Blur
-        // --------------------------------------------------
-        bool horizontal = true, first_iteration = true;
-        unsigned int amount = 10;
-        shaderBlur.use();
-        for (unsigned int i = 0; i < amount; i++)
-        {
-            glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[horizontal]);
-            shaderBlur.setInt("horizontal", horizontal);
-            glBindTexture(GL_TEXTURE_2D, first_iteration ? colorBuffers[1] : pingpongColorbuffers[!horizontal]);  // bind texture of other framebuffer (or scene if first iteration)
-            renderQuad();
-            horizontal = !horizontal;
-            if (first_iteration)
-                first_iteration = false;
+        // don't forget to enable shader before setting uniforms
+        for (Shader *shader : {&ourShader, &ourShaderCutout, &ourShaderBlend}) {
+            shader->use();
+            shader->setInt("blinn", blinn);
         }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        //Face culling
+        glState.enable(GL_CULL_FACE);
+        glState.cullFace(GL_BACK);
+
+        // input, then the update: threaded, this frame was updated during the last one and the
+        // input goes to the next, which is updated while this one is submitted; unthreaded, this
+        // frame is updated right here with the input just read, which is as late as it gets
+        // -----
+        if (!headless) {
+            RG_TRACE_ZONE("glfwPollEvents");
+            glfwPollEvents();
+            processInput(window);
+        }
+        if (!pipeline.pending())
+            startUpdate(currentFrame, deltaTime);
+        const SimulatedFrame &simulated = pipeline.acquire();
+        if (pipeline.threaded()) {
+            // the next frame is predicted to take as long as this one
+            const float step = fixedTimestep ? 1.0f / 60.0f : deltaTime;
+            startUpdate(fixedTimestep ? (framesRendered + 1) / 60.0f : currentFrame + step, step);
+        }
+        const std::vector<SceneObject> &sceneObjects = simulated.objects;
+        const std::vector<rg::PointLightInstance> &pointLights = simulated.pointLights;
+        const std::vector<BlendedDraw> &blendedDraws = simulated.blendedDraws;
+        const glm::mat4 &view = simulated.view;
+        const glm::mat4 &projection = simulated.projection;
+
+        // view/projection transformations go to the shared uniform block
+        frameData.view = view;
+        frameData.projection = projection;
+        frameData.cameraPosition = simulated.camera.Position;
+        frameData.time = simulated.time;
+        frameData.deltaTime = simulated.deltaTime;
+        frameBuffer.update(frameData);
+        lightClusters->upload(simulated.lightGrid, pointLights, width, height);
+
+        auto drawScene = [&sceneObjects](Shader &shader, int modelLoc, MeshFilter filter) {
+            shader.use();
+            for (const SceneObject &object : sceneObjects) {
+                if (filter == MESHES_ALPHA_TESTED && !object.model->HasAlphaTestedMeshes())
+                    continue;
+                shader.setMat4(modelLoc, object.transform);
+                object.model->Draw(shader, filter);
+            }
+        };
+
+        // render
+        // ------
+        // the passes only declare what they read and write here, execute() below culls the ones
+        // whose results nobody uses and runs the rest with targets taken from the pool
+        rg::RenderGraph &graph = *renderGraph;
+        rg::FrameResources frame = rg::FrameResources();
+        frame.width = width;
+        frame.height = height;
+        frame.view = view;
+        frame.projection = projection;
+        frame.drawQuad = renderQuad;
+        const glm::vec4 clearColor = glm::vec4(programState->clearColor, 1.0f);
+        rg::RGTexture backbuffer = graph.import("backbuffer", offscreenTexture, displayWidth, displayHeight);
+        // 1. render scene into floating point framebuffer
+        // -----------------------------------------------
+        // alpha is never read back, 11/11/10 float is half the bandwidth of RGBA16F
+        frame.sceneColor = graph.create("scene color", rg::RenderTargetDesc{width, height, GL_R11F_G11F_B10F, GL_LINEAR});
+        // a texture so the depth effects can read it back
+        rg::RGTexture sceneDepth = graph.create("scene depth", rg::RenderTargetDesc{width, height, GL_DEPTH_COMPONENT24, GL_NEAREST});
+
+        // the shading passes multiply in ambient occlusion from the unit after the material slots
+        auto bindAmbientOcclusion = [&](rg::RenderGraph::Context &context) {
+            unsigned int texture = frame.ambientOcclusion.valid() ? context.texture(frame.ambientOcclusion) : whiteTexture;
+            glState.bindTexture(MATERIAL_SLOT_COUNT, GL_TEXTURE_2D, texture);
+            return texture;
+        };
+
+        if (renderPath == RENDER_DEFERRED) {
+            rg::RGTexture gNormal = graph.create("g-buffer normal", rg::GBuffer::normalDesc(width, height));
+            rg::RGTexture gAlbedoSpecular = graph.create("g-buffer albedo", rg::GBuffer::albedoSpecularDesc(width, height));
+            rg::RGTexture gDepth = graph.create("g-buffer depth", rg::GBuffer::depthDesc(width, height));
+            graph.addPass("G-buffer", [&](rg::RenderGraph::Context &) {
+                glState.depthFunc(GL_LEQUAL);
+                drawScene(gBufferShader, gBufferModelLoc, MESHES_OPAQUE);
+                drawScene(gBufferCutoutShader, gBufferCutoutModelLoc, MESHES_ALPHA_TESTED);
+            }).color(gNormal, rg::LOAD_OP_CLEAR).color(gAlbedoSpecular, rg::LOAD_OP_CLEAR).depth(gDepth, rg::LOAD_OP_CLEAR);
+
+            frame.sceneDepth = gDepth;
+            effects.addPasses(rg::EFFECT_STAGE_DEPTH, graph, frame);
+
+            const glm::mat4 inverseViewProjection = glm::inverse(projection * view);
+            graph.addPass("Deferred lighting", [&, gNormal, gAlbedoSpecular, gDepth, inverseViewProjection](rg::RenderGraph::Context &context) {
+                rg::GBuffer gBuffer;
+                gBuffer.normal = context.texture(gNormal);
+                gBuffer.albedoSpecular = context.texture(gAlbedoSpecular);
+                gBuffer.depth = context.texture(gDepth);
+                unsigned int aoTexture = bindAmbientOcclusion(context);
+                // everything drawn forward afterwards (light cubes, sky, blended meshes) tests against the scene depth
+                glState.blitFramebuffer(renderTargets->framebuffer({}, gBuffer.depth), context.framebuffer(), width, height, GL_DEPTH_BUFFER_BIT);
+                deferredLighting.render(gBuffer, aoTexture, pointLights, inverseViewProjection, renderQuad);
+            }).read(gNormal).read(gAlbedoSpecular).read(gDepth).read(frame.ambientOcclusion)
+              .color(frame.sceneColor, rg::LOAD_OP_CLEAR, clearColor).depth(sceneDepth, rg::LOAD_OP_DONT_CARE);
+            frame.sceneDepth = sceneDepth;
+        } else if (effects.anyEnabled(rg::EFFECT_STAGE_DEPTH) || depthPrepass->active()) {
+            // the depth effects read the pre-pass depth, so they keep the pre-pass on
+            // depth-only pre-pass: position-only for opaque meshes, alpha test only for foliage
+            graph.addPass("Depth pre-pass", [&](rg::RenderGraph::Context &) {
+                depthPrepass->beginMeasure();
+                glState.depthFunc(GL_LESS);
+                glState.colorMask(false);
+                prepassShader.use();
+                for (const SceneObject &object : sceneObjects) {
+                    prepassShader.setMat4(prepassModelLoc, object.transform);
+                    object.model->DrawOpaqueGeometry();
+                }
+                drawScene(prepassCutoutShader, prepassCutoutModelLoc, MESHES_ALPHA_TESTED);
+                glState.colorMask(true);
+                depthPrepass->endMeasure(width * height);
+            }).depth(sceneDepth, rg::LOAD_OP_CLEAR);
+
+            frame.sceneDepth = sceneDepth;
+            effects.addPasses(rg::EFFECT_STAGE_DEPTH, graph, frame);
+
+            // depth is final, shade each visible pixel once without any discard
+            graph.addPass("Forward opaque", [&](rg::RenderGraph::Context &context) {
+                bindAmbientOcclusion(context);
+                glState.depthFunc(GL_EQUAL);
+                glState.depthMask(false);
+                drawScene(ourShader, ourModelLoc, MESHES_DEPTH_WRITING);
+                glState.depthMask(true);
+            }).read(frame.ambientOcclusion).color(frame.sceneColor, rg::LOAD_OP_CLEAR, clearColor).depth(sceneDepth, rg::LOAD_OP_LOAD);
+        } else {
+            graph.addPass("Forward opaque", [&](rg::RenderGraph::Context &context) {
+                bindAmbientOcclusion(context);
+                depthPrepass->beginMeasure();
+                glState.depthFunc(GL_LEQUAL);
+                drawScene(ourShader, ourModelLoc, MESHES_OPAQUE);
+                drawScene(ourShaderCutout, ourCutoutModelLoc, MESHES_ALPHA_TESTED);
+                depthPrepass->endMeasure(width * height);
+            }).color(frame.sceneColor, rg::LOAD_OP_CLEAR, clearColor).depth(sceneDepth, rg::LOAD_OP_CLEAR);
+            frame.sceneDepth = sceneDepth;
+        }
+
+        // light sources as white cubes, then the sky behind everything
+        graph.addPass("Lights and sky", [&](rg::RenderGraph::Context &) {
+            glState.depthFunc(GL_LEQUAL);
+            shaderLight.use();
+            for (unsigned int i = 0; i < lightPositions.size(); i++) {
+                glm::mat4 cube = glm::mat4(1.0f);
+                cube = glm::translate(cube, glm::vec3(lightPositions[i]) + glm::vec3(0.0f, cos(simulated.time)*0.1f, 0.0f));
+                cube = glm::scale(cube, glm::vec3(0.18f));
+                shaderLight.setMat4(lightModelLoc, cube);
+                shaderLight.setVec3(lightColorLoc, lightColors[i]);
+                renderCube();
+            }
+
+            glState.disable(GL_CULL_FACE);
+
+            // skybox cube
+            skyboxShader.use();
+            glState.bindVertexArray(skyBoxVAO);
+            glState.bindTexture(0, GL_TEXTURE_CUBE_MAP, cubemapTexture);
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+            rg::countDraw(12);
+        }).color(frame.sceneColor, rg::LOAD_OP_LOAD).depth(frame.sceneDepth, rg::LOAD_OP_LOAD);
+
+        // blended meshes last, after the sky they show through: back to front,
+        // tested against the finished depth buffer without writing to it
+        if (!blendedDraws.empty()) {
+            graph.addPass("Blended", [&](rg::RenderGraph::Context &context) {
+                bindAmbientOcclusion(context);
+                glState.depthFunc(GL_LEQUAL);
+                glState.disable(GL_CULL_FACE);
+                glState.enable(GL_BLEND);
+                glState.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                glState.depthMask(false);
+                ourShaderBlend.use();
+                for (const BlendedDraw &draw : blendedDraws) {
+                    ourShaderBlend.setMat4(ourBlendModelLoc, draw.object->transform);
+                    draw.object->model->DrawMesh(ourShaderBlend, draw.mesh);
+                }
+                glState.depthMask(true);
+                glState.disable(GL_BLEND);
+            }).read(frame.ambientOcclusion).color(frame.sceneColor, rg::LOAD_OP_LOAD).depth(frame.sceneDepth, rg::LOAD_OP_LOAD);
+        }
+
+        // 2. effects on the finished HDR image (bloom)
+        // --------------------------------------------
+        effects.addPasses(rg::EFFECT_STAGE_POST, graph, frame);
 
         // 3. now render floating point color buffer to 2D quad and tonemap HDR colors to default framebuffer's (clamped) color range
         // --------------------------------------------------------------------------------------------------------------------------
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        shaderBloomFinal.use();
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, colorBuffers[0]);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[!horizontal]);
-        shaderBloomFinal.setInt("bloom", bloom);
-        shaderBloomFinal.setFloat("exposure", exposure);
-        renderQuad();
-
-        if (programState->ImGuiEnabled)
+        if (outputView == OUTPUT_FINAL) {
+            graph.addPass("Tonemap", [&](rg::RenderGraph::Context &context) {
+                glState.disable(GL_DEPTH_TEST);
+                shaderBloomFinal.use();
+                glState.bindTexture(0, GL_TEXTURE_2D, context.texture(frame.sceneColor));
+                if (frame.bloom.valid())
+                    glState.bindTexture(1, GL_TEXTURE_2D, context.texture(frame.bloom));
+                shaderBloomFinal.setBool(bloomFinalBloomLoc, frame.bloom.valid());
+                shaderBloomFinal.setFloat(bloomFinalExposureLoc, exposure);
+                // bilinear upscale from the scaled scene, sharpened to win back some detail
+                shaderBloomFinal.setFloat(bloomFinalSharpnessLoc, width < displayWidth ? dynamicResolution->sharpness : 0.0f);
+                renderQuad();
+                glState.enable(GL_DEPTH_TEST);
+            }).read(frame.sceneColor).read(frame.bloom).color(backbuffer, rg::LOAD_OP_DONT_CARE);
+        } else {
+            // black when the effect that makes the texture is off
+            rg::RGTexture shown = outputView == OUTPUT_AMBIENT_OCCLUSION ? frame.ambientOcclusion : frame.bloom;
+            graph.addPass("Debug view", [&, shown](rg::RenderGraph::Context &context) {
+                if (!shown.valid())
+                    return;
+                glState.disable(GL_DEPTH_TEST);
+                debugViewShader.use();
+                debugViewShader.setBool(debugViewGreyLoc, outputView == OUTPUT_AMBIENT_OCCLUSION);
+                glState.bindTexture(0, GL_TEXTURE_2D, context.texture(shown));
+                renderQuad();
+                glState.enable(GL_DEPTH_TEST);
+            }).read(shown).color(backbuffer, shown.valid() ? rg::LOAD_OP_DONT_CARE : rg::LOAD_OP_CLEAR);
+        }
+
+        graph.execute();
+        const float cpuMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+        dynamicResolution->update(graph.gpuMilliseconds());
+        glState.endFrame();
+        renderTargets->endFrame();
+        rg::gpuMemory().checkBudget(std::cout);
+        for (Model *drawn : models)
+            drawn->EndFrame();
+
+        // ImGui saves and restores every piece of state it touches, so the cache stays valid
+        if (programState->ImGuiEnabled || perfHud->visible) {
+            RG_GL_DEBUG_GROUP("ImGui");
+            profiler.begin("ImGui");
             DrawImGui(programState);
+            profiler.end();
+        }
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        if (!headless) {
+            RG_TRACE_ZONE("glfwSwapBuffers");
+            glfwSwapBuffers(window);
+            latencyMeter->endFrame(simulated.latched);
+        }
+#ifdef RG_GL_STATS
+        rg::glStats().endFrame();
+#endif
+        framesRendered++;
+        const float frameMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+        frameStats.add(frameMilliseconds, renderGraph->gpuMilliseconds(), rg::drawCounters());
+        perfHud->record(rg::HudSample{frameMilliseconds, cpuMilliseconds, renderGraph->gpuMilliseconds(), rg::drawCounters(),
+                                      glState.lastFrameCounters(), (unsigned int) sceneObjects.size(), simulated.culledObjects,
+                                      framePacer.mode, framePacer.targetFps, latencyMeter->lastMilliseconds(),
+                                      latencyMeter->averageMilliseconds(), latencyMeter->maximumMilliseconds(),
+                                      pipeline.threaded(), pipeline.updateMilliseconds(), pipeline.waitMilliseconds()});
     }
 
-    programState->SaveToFile("resources/program_state.txt");
+    // the update thread may be a frame ahead, done with it before anything it uses goes away
+    pipeline.setThreaded(false);
+
+    if (headless) {
+        // waits for the GPU, so the time below covers the whole run
+        glFinish();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - loopStart).count();
+        std::cout << "Rendered " << framesRendered << " frames at " << framebufferWidth << "x" << framebufferHeight
+                  << ", " << seconds * 1000.0 / framesRendered << " ms per frame" << std::endl;
+        if (!options.output.empty() && !writePPM(options.output, offscreenFBO, framebufferWidth, framebufferHeight))
+            std::cout << "Failed to write " << options.output << std::endl;
+        glDeleteFramebuffers(1, &offscreenFBO);
+        glDeleteTextures(1, &offscreenTexture);
+        rg::gpuMemory().release(rg::GpuMemory::TEXTURE, offscreenTexture);
+    } else if (!replaying) {
+        programState->SaveToFile(options.scene);
+    }
+    if (replaying || headless || !options.report.empty()) {
+        frameStats.print(std::cout);
+        if (!options.report.empty() && !frameStats.writeJson(options.report))
+            std::cout << "Failed to write " << options.report << std::endl;
+    }
+    if (!options.record.empty() && !cameraPath.save(options.record))
+        std::cout << "Failed to write " << options.record << std::endl;
+#ifdef RG_GL_STATS
+    if (!options.glStats.empty()) {
+        rg::glStats().printAverage(std::cout);
+        if (!rg::glStats().writeCsv(options.glStats))
+            std::cout << "Failed to write " << options.glStats << std::endl;
+    }
+#endif
+    RG_TRACE_WRITE("trace.json");
     delete programState;
+    delete depthPrepass;
+    rg::effectRegistry().destroy();
+    rg::gpuProfiler().destroy();
+    delete renderGraph;
+    delete dynamicResolution;
+    delete renderTargets;
+    delete lightClusters;
+    delete perfHud;
+    delete latencyMeter;
+    if (headless)
+        return 0;
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -881,9 +1242,12 @@ int main() {
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
 // ---------------------------------------------------------------------------------------------------------
 void processInput(GLFWwindow *window) {
+    RG_TRACE_ZONE("processInput");
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
 
+    if (replayingCameraPath)
+        return;
     if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
         programState->camera.ProcessKeyboard(FORWARD, deltaTime);
     if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
@@ -902,6 +1266,9 @@ void framebuffer_size_callback(GLFWwindow *window, int width, int height) {
     // make sure the viewport matches the new window dimensions; note that width and
     // height will be significantly larger than specified on retina displays.
     glViewport(0, 0, width, height);
+    // the render targets follow on the next frame, the pool drops the old sizes a few frames later
+    framebufferWidth = (unsigned int) width;
+    framebufferHeight = (unsigned int) height;
 }
 
 // glfw: whenever the mouse moves, this callback is called
@@ -919,14 +1286,15 @@ void mouse_callback(GLFWwindow *window, double xpos, double ypos) {
     lastX = xpos;
     lastY = ypos;
 
-    if (programState->CameraMouseMovementUpdateEnabled)
+    if (programState->CameraMouseMovementUpdateEnabled && !replayingCameraPath)
         programState->camera.ProcessMouseMovement(xoffset, yoffset);
 }
 
 // glfw: whenever the mouse scroll wheel scrolls, this callback is called
 // ----------------------------------------------------------------------
 void scroll_callback(GLFWwindow *window, double xoffset, double yoffset) {
-    programState->camera.ProcessMouseScroll(yoffset);
+    if (!replayingCameraPath)
+        programState->camera.ProcessMouseScroll(yoffset);
 }
 
 unsigned int loadCubemap(vector<std::string> faces)
@@ -934,8 +1302,9 @@ unsigned int loadCubemap(vector<std::string> faces)
     unsigned int textureID;
     glGenTextures(1, &textureID);
     glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+    RG_GL_LABEL(GL_TEXTURE, textureID, faces.empty() ? std::string("cubemap") : faces[0]);
 
-    int width, height, nrChannels;
+    int width = 0, height = 0, nrChannels;
     for (unsigned int i = 0; i < faces.size(); i++)
     {
         unsigned char *data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
@@ -955,16 +1324,25 @@ unsigned int loadCubemap(vector<std::string> faces)
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    rg::gpuMemory().trackTexture(textureID, width, height, GL_RGB, false, RG_GPU_MEMORY_SITE, "skybox", 6);
 
     return textureID;
 }
 
 
 void DrawImGui(ProgramState *programState) {
+    RG_TRACE_ZONE("DrawImGui");
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
 
+    perfHud->draw(*renderGraph, *renderTargets);
+    // F2 shows the HUD on its own, without the windows below
+    if (!programState->ImGuiEnabled) {
+        ImGui::Render();
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        return;
+    }
 
     {
         static float f = 0.0f;
@@ -994,11 +1372,137 @@ void DrawImGui(ProgramState *programState) {
         ImGui::End();
     }
 
+    {
+        ImGui::Begin("Render path");
+        const char *paths[] = {"Forward", "Deferred", "Clustered forward"};
+        int path = renderPath;
+        if (ImGui::Combo("Path", &path, paths, 3))
+            renderPath = (RenderPath) path;
+        ImGui::SliderInt("Lanterns", &lanternCount, 0, MAX_LANTERNS);
+        const rg::LightGrid &grid = lightClusters->grid();
+        ImGui::Text("Light grid: %ux%ux%u, %u threads", rg::LightGrid::TILES_X, rg::LightGrid::TILES_Y,
+                    rg::LightGrid::SLICES, lightClusters->workerThreads());
+        ImGui::Text("Binned %u lights into %u entries in %.3f ms", grid.lightCount(), grid.indexCount(),
+                    lightClusters->buildMilliseconds());
+        ImGui::Text("Most lights in one cluster: %u (%u dropped)", grid.maxClusterLights(), grid.overflow());
+        ImGui::End();
+    }
+
+    for (const std::unique_ptr<rg::Effect> &effect : rg::effectRegistry().effects()) {
+        ImGui::Begin(effect->name());
+        ImGui::Checkbox("Enabled", &effect->enabled);
+        effect->drawSettings();
+        ImGui::End();
+    }
+
+    {
+        ImGui::Begin("Render graph");
+        const char *outputs[] = {"Final", "Ambient occlusion", "Bloom"};
+        int output = outputView;
+        if (ImGui::Combo("Output", &output, outputs, 3))
+            outputView = (OutputView) output;
+        ImGui::DragFloat("Exposure", &exposure, 0.05, 0.1, 10.0);
+        ImGui::Separator();
+        for (const rg::RenderGraph::PassStats &pass : renderGraph->stats()) {
+            if (pass.culled)
+                ImGui::TextDisabled("%s: culled", pass.name.c_str());
+            else
+                ImGui::Text("%s: %.3f ms CPU, %.3f ms GPU", pass.name.c_str(), pass.cpuMilliseconds, pass.gpuMilliseconds);
+        }
+        ImGui::End();
+    }
+
+    {
+        ImGui::Begin("Depth pre-pass");
+        const char *modes[] = {"Off", "On", "Auto"};
+        int mode = depthPrepass->mode;
+        if (ImGui::Combo("Mode", &mode, modes, 3))
+            depthPrepass->mode = (rg::DepthPrepassMode) mode;
+        ImGui::Text("Active: %s", depthPrepass->active() ? "yes" :
+                    (rg::effectRegistry().anyEnabled(rg::EFFECT_STAGE_DEPTH) ? "yes (a depth effect needs it)" : "no"));
+        ImGui::Text("Measured overdraw: %.2f samples/pixel", depthPrepass->overdraw());
+        ImGui::End();
+    }
+
+#ifdef RG_GPU_PROFILER
+    {
+        ImGui::Begin("GPU profiler");
+        ImGui::Text("%-20s %8s %8s %8s", "Pass", "min", "avg", "max");
+        for (const rg::GpuTimerStats &timer : rg::gpuProfiler().stats())
+            ImGui::Text("%-20s %8.3f %8.3f %8.3f", timer.name.c_str(), timer.minimum, timer.average, timer.maximum);
+        ImGui::Text("ms over the last %u frames, read %u frames late", rg::GpuProfiler::HISTORY, rg::GpuProfiler::LATENCY_FRAMES);
+        static const char *exported = "";
+        if (ImGui::Button("Export CSV"))
+            exported = rg::gpuProfiler().writeCsv("gpu_profile.csv") ? "Wrote gpu_profile.csv" : "Couldn't write gpu_profile.csv";
+        ImGui::SameLine();
+        if (ImGui::Button("Export JSON"))
+            exported = rg::gpuProfiler().writeJson("gpu_profile.json") ? "Wrote gpu_profile.json" : "Couldn't write gpu_profile.json";
+        ImGui::Text("%s", exported);
+        ImGui::End();
+    }
+#endif
+
+    {
+        ImGui::Begin("Dynamic resolution");
+        ImGui::Checkbox("Enabled", &dynamicResolution->enabled);
+        if (dynamicResolution->enabled) {
+            ImGui::DragFloat("GPU target (ms)", &dynamicResolution->targetMilliseconds, 0.1, 1.0, 100.0);
+        } else {
+            float scale = dynamicResolution->scale();
+            if (ImGui::SliderFloat("Scale", &scale, dynamicResolution->minScale, dynamicResolution->maxScale))
+                dynamicResolution->setScale(scale);
+        }
+        ImGui::SliderFloat("Minimum scale", &dynamicResolution->minScale, 0.25f, 1.0f);
+        ImGui::SliderFloat("Sharpness", &dynamicResolution->sharpness, 0.0f, 2.0f);
+        ImGui::Text("Scale: %.0f%% (%ux%u of %ux%u)", dynamicResolution->scale() * 100.0f,
+                    dynamicResolution->scaled(framebufferWidth), dynamicResolution->scaled(framebufferHeight),
+                    framebufferWidth, framebufferHeight);
+        ImGui::Text("GPU frame time: %.2f ms", dynamicResolution->smoothedMilliseconds());
+        ImGui::End();
+    }
+
+    {
+        ImGui::Begin("Frame pacing");
+        const char *modes[] = {"VSync", "Adaptive VSync", "Uncapped", "Capped"};
+        int mode = framePacer.mode;
+        if (ImGui::Combo("Mode", &mode, modes, rg::PACING_MODE_COUNT))
+            framePacer.mode = (rg::PacingMode) mode;
+        if (framePacer.mode == rg::PACING_CAPPED)
+            ImGui::DragFloat("Frame rate", &framePacer.targetFps, 1.0f, 10.0f, 500.0f);
+        ImGui::Text("Input to frame done: %.2f ms (average %.2f, max %.2f)", latencyMeter->lastMilliseconds(),
+                    latencyMeter->averageMilliseconds(), latencyMeter->maximumMilliseconds());
+        // a frame ahead costs a frame of latency, for a frame time of the slower of update and submit
+        ImGui::Checkbox("Update the next frame on its own thread", &pipelinedUpdate);
+        ImGui::End();
+    }
+
+    {
+        ImGui::Begin("Render targets");
+        ImGui::Text("Size: %ux%u", framebufferWidth, framebufferHeight);
+        ImGui::Text("Pooled targets: %u, %.2f MB", renderTargets->targetCount(), renderTargets->bytes() / (1024.0 * 1024.0));
+        ImGui::Text("Shared within the last frame: %u", renderTargets->aliasedLastFrame());
+        ImGui::End();
+    }
+
+    {
+        ImGui::Begin("GL state");
+        const rg::GLState::Counters& counters = rg::glState().lastFrameCounters();
+        ImGui::Text("State calls issued: %lu", counters.issued);
+        ImGui::Text("State calls skipped: %lu", counters.skipped);
+        ImGui::End();
+    }
+
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 }
 
 void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods) {
+    if (key == GLFW_KEY_F2 && action == GLFW_PRESS)
+        perfHud->visible = !perfHud->visible;
+#ifdef RG_GL_STATS
+    if (key == GLFW_KEY_F3 && action == GLFW_PRESS)
+        rg::glStats().printLastFrame(std::cout);
+#endif
     if (key == GLFW_KEY_F1 && action == GLFW_PRESS) {
         programState->ImGuiEnabled = !programState->ImGuiEnabled;
         if (programState->ImGuiEnabled) {
@@ -1030,8 +1534,10 @@ unsigned int loadTexture(char const *path)
             format = GL_RGBA;
 
         glBindTexture(GL_TEXTURE_2D, textureID);
+        RG_GL_LABEL(GL_TEXTURE, textureID, path);
         glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
         glGenerateMipmap(GL_TEXTURE_2D);
+        rg::gpuMemory().trackTexture(textureID, width, height, format, true, RG_GPU_MEMORY_SITE, path);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -1049,6 +1555,44 @@ unsigned int loadTexture(char const *path)
     return textureID;
 }
 
+// 1x1 white single channel texture
+unsigned int createWhiteTexture()
+{
+    unsigned char white = 255;
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    RG_GL_LABEL(GL_TEXTURE, textureID, "white");
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, 1, 1, 0, GL_RED, GL_UNSIGNED_BYTE, &white);
+    rg::gpuMemory().trackTexture(textureID, 1, 1, GL_R8, false, RG_GPU_MEMORY_SITE, "white");
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    rg::glState().invalidate();
+    return textureID;
+}
+
+// reads the color attachment of framebuffer back into a binary PPM, top row first
+bool writePPM(const std::string &path, unsigned int framebuffer, unsigned int width, unsigned int height)
+{
+    std::vector<unsigned char> pixels(width * height * 3);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, &pixels[0]);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    rg::glState().invalidate();
+
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+        return false;
+    out << "P6\n" << width << " " << height << "\n255\n";
+    // GL's first row is the bottom one
+    for (unsigned int y = height; y-- > 0;)
+        out.write((const char *) &pixels[y * width * 3], width * 3);
+    return (bool) out;
+}
+
 // renderQuad() renders a 1x1 XY quad in NDC
 unsigned int quadVAO = 0;
 unsigned int quadVBO;
@@ -1065,17 +1609,18 @@ void renderQuad() {
         // setup plane VAO
         glGenVertexArrays(1, &quadVAO);
         glGenBuffers(1, &quadVBO);
-        glBindVertexArray(quadVAO);
+        rg::glState().bindVertexArray(quadVAO);
         glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
+        rg::gpuMemory().trackBuffer(quadVBO, sizeof(quadVertices), RG_GPU_MEMORY_SITE, "quad");
         glEnableVertexAttribArray(0);
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
         glEnableVertexAttribArray(1);
         glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
     }
-    glBindVertexArray(quadVAO);
+    rg::glState().bindVertexArray(quadVAO);
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    glBindVertexArray(0);
+    rg::countDraw(2);
 }
 
 // renderCube() renders a 1x1 3D cube in NDC.
@@ -1135,8 +1680,9 @@ void renderCube()
         // fill buffer
         glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+        rg::gpuMemory().trackBuffer(cubeVBO, sizeof(vertices), RG_GPU_MEMORY_SITE, "cube");
         // link vertex attributes
-        glBindVertexArray(cubeVAO);
+        rg::glState().bindVertexArray(cubeVAO);
         glEnableVertexAttribArray(0);
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
         glEnableVertexAttribArray(1);
@@ -1144,10 +1690,9 @@ void renderCube()
         glEnableVertexAttribArray(2);
         glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
         glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
     }
     // render Cube
-    glBindVertexArray(cubeVAO);
+    rg::glState().bindVertexArray(cubeVAO);
     glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
+    rg::countDraw(12);
 }
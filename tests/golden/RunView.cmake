@@ -0,0 +1,34 @@
+# Renders one golden view headless and checks it, run by ctest as
+#   cmake -DAPP= -DCHECK= -DSOURCE_DIR= -DOUT_DIR= -DNAME= -DCAMERA= -DRENDER_PATH=
+#         -DWIDTH= -DHEIGHT= -DMIN_PSNR= -DUPDATE= -P RunView.cmake
+# With UPDATE on, the rendered image replaces the reference instead of being compared to it.
+# Without UPDATE a view that has no reference fails.
+
+file(MAKE_DIRECTORY ${OUT_DIR})
+set(image ${OUT_DIR}/${NAME}.ppm)
+set(report ${OUT_DIR}/${NAME}.json)
+set(reference ${SOURCE_DIR}/tests/golden/reference/${NAME}.ppm)
+
+# a few frames so the GPU timer results of the first ones come back
+execute_process(
+        COMMAND ${APP} --headless --width ${WIDTH} --height ${HEIGHT} --frames 8 --path ${RENDER_PATH}
+                --replay ${SOURCE_DIR}/tests/golden/views/${CAMERA} --output ${image} --report ${report}
+        WORKING_DIRECTORY ${SOURCE_DIR}
+        RESULT_VARIABLE result)
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "${NAME}: rendering failed (${result})")
+endif()
+
+if (UPDATE)
+    file(COPY ${image} DESTINATION ${SOURCE_DIR}/tests/golden/reference)
+    message(STATUS "${NAME}: reference updated")
+    return()
+endif()
+
+execute_process(
+        COMMAND ${CHECK} --name ${NAME} --image ${image} --reference ${reference} --diff ${OUT_DIR}/${NAME}.diff.ppm
+                --min-psnr ${MIN_PSNR} --report ${report} --budgets ${SOURCE_DIR}/tests/golden/budgets.txt
+        RESULT_VARIABLE result)
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "${NAME}: check failed")
+endif()
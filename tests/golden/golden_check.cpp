@@ -0,0 +1,142 @@
+// Checks one rendered golden view: the image against its reference (PSNR over RGB, a diff
+// image written when it fails) and the frame statistics of the run (the --report JSON)
+// against the view's line in the budget file. Exits non-zero when any check fails, a missing
+// reference included (RunView.cmake doesn't call this while updating the references).
+//
+// usage: golden_check --name NAME --image OUT.ppm --reference REF.ppm --diff DIFF.ppm
+//                     --min-psnr DB [--report RUN.json --budgets budgets.txt]
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct Image {
+    unsigned int width = 0, height = 0;
+    std::vector<unsigned char> pixels;  // RGB, top row first
+};
+
+static bool readPPM(const std::string &path, Image &image) {
+    std::ifstream in(path, std::ios::binary);
+    std::string magic;
+    unsigned int maximum = 0;
+    in >> magic >> image.width >> image.height >> maximum;
+    if (!in || magic != "P6" || maximum != 255)
+        return false;
+    in.get();
+    image.pixels.resize(image.width * image.height * 3);
+    in.read((char *) &image.pixels[0], image.pixels.size());
+    return (bool) in;
+}
+
+static bool writePPM(const std::string &path, const Image &image) {
+    std::ofstream out(path, std::ios::binary);
+    out << "P6\n" << image.width << " " << image.height << "\n255\n";
+    out.write((const char *) &image.pixels[0], image.pixels.size());
+    return (bool) out;
+}
+
+// infinite for identical images
+static double psnr(const Image &a, const Image &b) {
+    double squared = 0.0;
+    for (size_t i = 0; i < a.pixels.size(); i++) {
+        double difference = (double) a.pixels[i] - (double) b.pixels[i];
+        squared += difference * difference;
+    }
+    if (squared == 0.0)
+        return INFINITY;
+    double mse = squared / a.pixels.size();
+    return 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+// absolute difference, amplified so small errors are visible
+static Image difference(const Image &a, const Image &b) {
+    Image diff = a;
+    for (size_t i = 0; i < a.pixels.size(); i++) {
+        int value = std::abs((int) a.pixels[i] - (int) b.pixels[i]) * 8;
+        diff.pixels[i] = (unsigned char) (value > 255 ? 255 : value);
+    }
+    return diff;
+}
+
+// p95 of "frame_ms" or "gpu_ms" in a FrameStats report, negative when it isn't there
+static double reportP95(const std::string &report, const std::string &key) {
+    size_t at = report.find("\"" + key + "\"");
+    if (at == std::string::npos)
+        return -1.0;
+    at = report.find("\"p95\":", at);
+    if (at == std::string::npos)
+        return -1.0;
+    return std::atof(report.c_str() + at + 6);
+}
+
+int main(int argc, char **argv) {
+    std::map<std::string, std::string> args;
+    for (int i = 1; i + 1 < argc; i += 2)
+        args[argv[i]] = argv[i + 1];
+    const std::string name = args["--name"];
+    if (name.empty() || args["--image"].empty() || args["--reference"].empty() || args["--diff"].empty()) {
+        std::cerr << "usage: golden_check --name NAME --image OUT.ppm --reference REF.ppm --diff DIFF.ppm\n"
+                     "                    --min-psnr DB [--report RUN.json --budgets budgets.txt]\n";
+        return 2;
+    }
+    bool passed = true;
+
+    Image image, reference;
+    if (!readPPM(args["--image"], image)) {
+        std::cerr << name << ": can't read " << args["--image"] << "\n";
+        return 1;
+    }
+    // the budgets are still checked, so one run shows everything that's wrong
+    if (!readPPM(args["--reference"], reference)) {
+        std::cerr << name << ": no reference image " << args["--reference"]
+                  << ", render one with -DRG_GOLDEN_UPDATE=ON\n";
+        passed = false;
+    } else if (image.width != reference.width || image.height != reference.height) {
+        std::cerr << name << ": rendered " << image.width << "x" << image.height << ", reference is "
+                  << reference.width << "x" << reference.height << "\n";
+        return 1;
+    } else {
+        double minimum = std::atof(args["--min-psnr"].c_str());
+        double measured = psnr(image, reference);
+        std::cout << name << ": PSNR " << measured << " dB (at least " << minimum << ")\n";
+        if (measured < minimum) {
+            writePPM(args["--diff"], difference(image, reference));
+            std::cerr << name << ": image differs from the reference, see " << args["--diff"] << "\n";
+            passed = false;
+        }
+    }
+
+    // budget lines: name frame_p95_ms gpu_p95_ms, 0 leaves that one unchecked
+    if (!args["--report"].empty() && !args["--budgets"].empty()) {
+        std::ifstream reportFile(args["--report"]);
+        std::stringstream report;
+        report << reportFile.rdbuf();
+        std::ifstream budgets(args["--budgets"]);
+        std::string line;
+        while (std::getline(budgets, line)) {
+            std::istringstream fields(line);
+            std::string view;
+            double frameBudget = 0.0, gpuBudget = 0.0;
+            if (!(fields >> view >> frameBudget >> gpuBudget) || view != name)
+                continue;
+            double frame = reportP95(report.str(), "frame_ms");
+            double gpu = reportP95(report.str(), "gpu_ms");
+            if (frame < 0.0 || gpu < 0.0) {
+                std::cerr << name << ": no frame statistics in " << args["--report"] << "\n";
+                passed = false;
+                break;
+            }
+            std::cout << name << ": p95 frame " << frame << " ms (budget " << frameBudget << "), gpu " << gpu
+                      << " ms (budget " << gpuBudget << ")\n";
+            if ((frameBudget > 0.0 && frame > frameBudget) || (gpuBudget > 0.0 && gpu > gpuBudget)) {
+                std::cerr << name << ": over budget\n";
+                passed = false;
+            }
+        }
+    }
+    return passed ? 0 : 1;
+}